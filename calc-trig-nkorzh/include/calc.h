@@ -1,5 +1,210 @@
 #pragma once
 
-#include <string>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
 
-double process_line(double current, bool & rad_on, const std::string & line);
+/**
+ * How numeric arguments of operations are read
+ */
+struct ArgumentFormat
+{
+    // digits read at most, the rest of a longer number is reported as an unparsed suffix; 0 means no limit
+    std::size_t max_digits = 10;
+    // whether an exponent like e-3 may follow the digits
+    bool exponent = false;
+};
+
+/**
+ * Problems found in a line, several of them may be combined
+ */
+enum class Status : std::uint8_t
+{
+      Ok = 0
+    , UnknownOperation = 1 << 0
+    , UnparsedSuffix = 1 << 1
+    , BadArgument = 1 << 2
+    , DivisionByZero = 1 << 3
+    , RemainderByZero = 1 << 4
+    , BadRegister = 1 << 5
+    , NoRegisters = 1 << 6
+};
+
+constexpr Status operator | (const Status a, const Status b)
+{
+    return static_cast<Status>(static_cast<std::uint8_t>(a) | static_cast<std::uint8_t>(b));
+}
+
+constexpr bool has_status(const Status set, const Status status)
+{
+    return (static_cast<std::uint8_t>(set) & static_cast<std::uint8_t>(status)) != 0;
+}
+
+template <class Number>
+struct BasicResult
+{
+    Number value = 0;
+    Status status = Status::Ok;
+    // where the unparsed suffix of the argument starts, 0 for other problems
+    std::uint32_t position = 0;
+};
+
+using Result = BasicResult<double>;
+
+/**
+ * A problem of one line of a program or of one register of a batch
+ */
+struct Diagnostic
+{
+    // the problem is the same for all registers of a batch
+    static constexpr std::size_t whole_line = static_cast<std::size_t>(-1);
+
+    // index of the line in the program or of the register in the batch
+    std::size_t index = whole_line;
+    // as evaluate_line would return it for the line
+    Result result;
+};
+
+using Diagnostics = std::vector<Diagnostic>;
+
+/**
+ * Same as process_line, but problems are returned rather than written to std::cerr,
+ * so evaluation never does any I/O
+ */
+Result evaluate_line(double current, bool & rad_on, std::string_view line, const ArgumentFormat & format = {});
+
+template <class Number>
+struct NumberTag
+{
+    using type = Number;
+};
+
+/**
+ * Same as evaluate_line, but on another number type, which has to be given explicitly:
+ * float, double, long double or Decimal. Arguments are parsed right into it
+ * and every type has its own fully specialized evaluator.
+ */
+template <class Number>
+BasicResult<Number> evaluate_line(typename NumberTag<Number>::type current, bool & rad_on, std::string_view line,
+        const ArgumentFormat & format = {});
+
+/**
+ * Writes a message for every problem of the evaluated line, the same ones process_line reports
+ */
+void describe(std::ostream & out, std::string_view line, const Result & result, const ArgumentFormat & format = {});
+
+double process_line(double current, bool & rad_on, std::string_view line, const ArgumentFormat & format = {});
+
+/**
+ * Applies the line to every register, parsing it only once. Trigonometric
+ * functions use the SIMD kernels of vector_math, so they may differ from
+ * process_line within the error bounds documented there.
+ * Problems are returned rather than written: parse errors and a zero divisor
+ * once for the whole line, bad arguments of SQRT, ASIN, ACOS, LN and LOG
+ * once for every such register, which is left as it is.
+ */
+Diagnostics process_line_batch(double * registers, std::size_t count, bool & rad_on, std::string_view line,
+        const ArgumentFormat & format = {});
+
+/**
+ * A journal compiled once into instructions, one per line, which can be
+ * replayed from any starting value without parsing it again.
+ * Nothing is written anywhere: if problems isn't null, compile appends parse errors
+ * and every run evaluation errors there, in order of lines and indexed by them.
+ */
+class Program
+{
+public:
+    static Program compile(std::string_view script, const ArgumentFormat & format = {},
+            Diagnostics * problems = nullptr);
+
+    /**
+     * Applies all the lines to the current value, same as process_line does
+     * line by line; if results isn't null, the value after each line is stored there
+     */
+    double run(double current, bool & rad_on, double * results = nullptr, Diagnostics * problems = nullptr) const;
+
+    /**
+     * Same as run, but splits the script between threads: every chunk is searched
+     * for long runs of affine lines (SET, ADD, SUB, MUL, DIV by non-zero, NEG) in parallel.
+     * A run containing a SET ends with a value which doesn't depend on where it starts,
+     * so it is skipped and the lines in between are evaluated one after another;
+     * then the skipped runs are replayed from their entry values in parallel.
+     * Every value is computed by the same operations as run does, so results are exactly
+     * the same; scripts without SET gain nothing. Problems are the same as well.
+     */
+    double run_parallel(double current, bool & rad_on, double * results, std::size_t threads,
+            Diagnostics * problems = nullptr) const;
+
+    /// amount of lines in the script
+    std::size_t size() const;
+
+private:
+    struct Instruction
+    {
+        std::uint8_t op;
+        double arg;
+    };
+
+    // terminated by an END instruction
+    std::vector<Instruction> m_code;
+
+    template <bool record>
+    double execute(double current, bool & rad_on, double * results, Diagnostics * problems) const;
+};
+
+/**
+ * Calculator state of one user: the current value, a small register file
+ * filled by STO n and read back by RCL n, the angle mode and the amount of
+ * failed lines. It holds no heap memory and does no I/O, so lines are processed
+ * without allocations; problems of the last line are kept as its status.
+ */
+class CalcSession
+{
+public:
+    static constexpr std::size_t register_count = 8;
+
+    double process_line(std::string_view line, const ArgumentFormat & format = {});
+
+    double value() const;
+    double get_register(std::size_t index) const;
+    bool rad_on() const;
+    /// problems of the last line
+    Status status() const;
+    /// lines with any problems
+    std::size_t errors() const;
+
+private:
+    double m_current = 0;
+    std::array<double, register_count> m_registers{};
+    std::uint32_t m_errors = 0;
+    Status m_status = Status::Ok;
+    bool m_rad_on = false;
+};
+
+/**
+ * Sessions of many users kept side by side in one array; released slots are
+ * reused, so the memory only grows with the peak amount of concurrent sessions
+ */
+class SessionPool
+{
+public:
+    using Id = std::uint32_t;
+
+    explicit SessionPool(std::size_t capacity = 0);
+
+    /// a fresh session, valid until released
+    Id acquire();
+    void release(Id id);
+
+    CalcSession & operator [] (Id id);
+
+    /// amount of sessions in use
+    std::size_t size() const;
+
+private:
+    std::vector<CalcSession> m_sessions;
+    std::vector<Id> m_free;
+};
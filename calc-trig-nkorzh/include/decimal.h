@@ -0,0 +1,135 @@
+#pragma once
+
+#include <charconv>
+#include <iosfwd>
+#include <string_view>
+
+/**
+ * Fixed point number with 18 decimal digits after the point kept in a 128-bit
+ * integer, about ±1.7e20 in range. Sums and differences of decimal fractions
+ * are exact, products, quotients and integer powers are rounded half away from
+ * zero at the last digit, remainders are exact. Other functions go through
+ * long double. A result out of range is not a number, which like the IEEE NaN
+ * spreads through further operations and compares unequal to everything.
+ */
+class Decimal
+{
+public:
+    using Raw = __int128;
+
+    // digits after the point
+    static constexpr int fraction_digits = 18;
+    static constexpr Raw scale = 1000000000000000000;
+
+    constexpr Decimal() = default;
+
+    constexpr Decimal(const int value)
+        : m_raw(static_cast<Raw>(value) * scale)
+    {}
+
+    // rounded to the nearest fixed point value
+    explicit Decimal(long double value);
+
+    static constexpr Decimal from_raw(const Raw raw)
+    {
+        Decimal res;
+        res.m_raw = raw;
+        return res;
+    }
+
+    /**
+     * The value of digits times 10^exponent, characters other than digits are skipped;
+     * rounded half away from zero, not a number when out of range
+     */
+    static Decimal from_digits(std::string_view text, int exponent);
+
+    static constexpr Decimal nan()
+    {
+        return from_raw(nan_raw);
+    }
+
+    // the value times 10^18
+    constexpr Raw raw() const
+    {
+        return m_raw;
+    }
+
+    constexpr bool is_nan() const
+    {
+        return m_raw == nan_raw;
+    }
+
+    explicit operator long double() const;
+    explicit operator double() const;
+
+    friend Decimal operator + (Decimal a, Decimal b);
+    friend Decimal operator - (Decimal a, Decimal b);
+    friend Decimal operator * (Decimal a, Decimal b);
+    // not a number for a zero divisor
+    friend Decimal operator / (Decimal a, Decimal b);
+
+    friend constexpr Decimal operator - (const Decimal a)
+    {
+        return a.is_nan() ? a : from_raw(-a.m_raw);
+    }
+
+    friend constexpr bool operator == (const Decimal a, const Decimal b)
+    {
+        return !a.is_nan() && a.m_raw == b.m_raw;
+    }
+
+    friend constexpr bool operator != (const Decimal a, const Decimal b)
+    {
+        return !(a == b);
+    }
+
+    friend constexpr bool operator < (const Decimal a, const Decimal b)
+    {
+        return !a.is_nan() && !b.is_nan() && a.m_raw < b.m_raw;
+    }
+
+    friend constexpr bool operator > (const Decimal a, const Decimal b)
+    {
+        return b < a;
+    }
+
+    friend constexpr bool operator <= (const Decimal a, const Decimal b)
+    {
+        return a < b || a == b;
+    }
+
+    friend constexpr bool operator >= (const Decimal a, const Decimal b)
+    {
+        return b <= a;
+    }
+
+    // same as std::remainder: a - n * b with n the integer nearest to a / b, ties to even
+    friend Decimal remainder(Decimal a, Decimal b);
+    // exact up to rounding of every multiplication for integer exponents, through long double otherwise
+    friend Decimal pow(Decimal a, Decimal b);
+
+    friend Decimal sqrt(Decimal a);
+    friend Decimal sin(Decimal a);
+    friend Decimal cos(Decimal a);
+    friend Decimal tan(Decimal a);
+    friend Decimal asin(Decimal a);
+    friend Decimal acos(Decimal a);
+    friend Decimal atan(Decimal a);
+    friend Decimal log(Decimal a);
+    friend Decimal log10(Decimal a);
+    friend Decimal exp(Decimal a);
+
+private:
+    // the only value with no negation, so the rest of them is symmetric around zero
+    static constexpr Raw nan_raw = static_cast<Raw>(static_cast<unsigned __int128>(1) << 127);
+
+    Raw m_raw = 0;
+};
+
+/**
+ * Writes all the digits of the value, without trailing zeros after the point
+ * and without the point for integers; "nan" when it isn't a number
+ */
+std::to_chars_result to_chars(char * first, char * last, Decimal value);
+
+std::ostream & operator << (std::ostream & out, Decimal value);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "calc.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes messages about problems of evaluated lines on its own thread,
+ * so reporting a line only copies it into a queue. At most max_per_second
+ * lines are described each second and at most capacity of them wait in the queue,
+ * the rest are counted and summarized instead; zero means no limit.
+ * Everything queued is written out by the destructor.
+ */
+class DiagnosticSink
+{
+public:
+    explicit DiagnosticSink(std::ostream & out, std::size_t max_per_second = 0, std::size_t capacity = 0,
+            const ArgumentFormat & format = {});
+    ~DiagnosticSink();
+
+    DiagnosticSink(const DiagnosticSink &) = delete;
+    DiagnosticSink & operator = (const DiagnosticSink &) = delete;
+
+    /// lines without problems are ignored
+    void report(std::string_view line, const Result & result);
+
+private:
+    struct Entry
+    {
+        std::string line;
+        Result result;
+    };
+
+    std::ostream & m_out;
+    const std::size_t m_max_per_second;
+    const std::size_t m_capacity;
+    const ArgumentFormat m_format;
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::vector<Entry> m_queue;
+    std::size_t m_dropped = 0;
+    bool m_stop = false;
+    // started last, when everything it uses is initialized
+    std::thread m_writer;
+
+    void run();
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * Trigonometric functions of angles in degrees. The angle is reduced modulo 360
+ * exactly, then folded to at most 45 degrees and only that is converted to radians,
+ * so the result doesn't lose precision with the size of the angle. Multiples of
+ * 30 and 45 degrees give the correctly rounded values: sin 180 is 0, cos 60 is 0.5,
+ * tan 45 is 1 and tan 90 is infinity. Exact zeros are never negative.
+ * Instantiated for float, double, long double and Decimal.
+ */
+namespace trig {
+
+// the same as M_PI for double
+template <class Number>
+const Number pi = static_cast<Number>(3.141592653589793238462643383279502884L);
+
+template <class Number>
+Number sin_deg(Number degrees);
+
+template <class Number>
+Number cos_deg(Number degrees);
+
+template <class Number>
+Number tan_deg(Number degrees);
+
+} // namespace trig
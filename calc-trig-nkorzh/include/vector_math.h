@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Elementwise math over arrays of doubles, written as branch-free loops
+ * which the compiler turns into SIMD code. The kernels are those of fdlibm
+ * with every range branch computed and selected per lane.
+ * Functions work in place and take or return radians, except those of degrees. Measured against
+ * long double references, the error is at most:
+ *  - sin, cos: 1 ulp for |x| < 2^20 * pi / 2, larger arguments go through std::sin/std::cos
+ *  - tan: 2.5 ulp in the same range, std::tan beyond it
+ *  - asin, acos, atan: 1 ulp
+ *  - acot: 1.5 ulp, it is atan(1 / x) shifted to (0, pi)
+ *  - sin_deg, cos_deg: 1.5 ulp, tan_deg: 2.5 ulp for any angle; they take degrees,
+ *    reduce them exactly like trig does and give its values at multiples of 30 and 45,
+ *    angles over 2^45 go through trig
+ * Arguments out of the domain give NaN.
+ */
+namespace vector_math {
+
+void sin(double * values, std::size_t count);
+void cos(double * values, std::size_t count);
+void tan(double * values, std::size_t count);
+void asin(double * values, std::size_t count);
+void acos(double * values, std::size_t count);
+void atan(double * values, std::size_t count);
+void acot(double * values, std::size_t count);
+void sqrt(double * values, std::size_t count);
+void sin_deg(double * values, std::size_t count);
+void cos_deg(double * values, std::size_t count);
+void tan_deg(double * values, std::size_t count);
+
+} // namespace vector_math
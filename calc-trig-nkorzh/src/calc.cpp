@@ -1,14 +1,24 @@
 #include "calc.h"
+#include "decimal.h"
+#include "trig.h"
+#include "vector_math.h"
 
+#include <algorithm> // for std::min, std::fill
+#include <array>
 #include <cctype> // for std::isspace
+#include <charconv> // for std::from_chars
 #include <cmath> // various math functions
+#include <cstdint>
+#include <cstring> // for std::memcpy
 #include <iostream> // for error reporting via std::cerr
+#include <limits>
+#include <string>
+#include <thread>
+#include <type_traits>
 
 
 namespace {
 
-    const std::size_t max_decimal_digits = 10;
-
 enum class Op {
       ERR
     , SET
@@ -28,16 +38,21 @@ enum class Op {
     , ACOS
     , ATAN
     , ACTN
+    , LN
+    , LOG
+    , EXP
+    , STO
+    , RCL
     , RAD
     , DEG
+    , END // terminates compiled programs
 };
 
-__inline double DegToRad(double _x) {
-    return (_x * M_PI / 180.0);
-}
+using trig::pi;
 
-__inline double RadToDeg(double _x) {
-    return (_x * 180.0 / M_PI);
+template <class Number>
+__inline Number RadToDeg(Number _x) {
+    return (_x * Number(180) / pi<Number>);
 }
 
 std::size_t arity(const Op op)
@@ -56,6 +71,9 @@ std::size_t arity(const Op op)
         case Op::ACOS: return 1;
         case Op::ATAN: return 1;
         case Op::ACTN:  return 1;
+        case Op::LN: return 1;
+        case Op::LOG: return 1;
+        case Op::EXP: return 1;
             // binary
         case Op::SET: return 2;
         case Op::ADD: return 2;
@@ -64,177 +82,139 @@ std::size_t arity(const Op op)
         case Op::DIV: return 2;
         case Op::REM: return 2;
         case Op::POW: return 2;
+        case Op::STO: return 2;
+        case Op::RCL: return 2;
         default: return 0;
     }
 }
 
-Op parse_op(const std::string & line, std::size_t & i)
+struct Mnemonic
 {
-    const auto rollback = [&i, &line] (const std::size_t n) {
-        i -= n;
-        std::cerr << "Unknown operation " << line << std::endl;
-        return Op::ERR;
-    };
-    switch (line[i++]) {
-        case '0': [[fallthrough]];
-        case '1': [[fallthrough]];
-        case '2': [[fallthrough]];
-        case '3': [[fallthrough]];
-        case '4': [[fallthrough]];
-        case '5': [[fallthrough]];
-        case '6': [[fallthrough]];
-        case '7': [[fallthrough]];
-        case '8': [[fallthrough]];
-        case '9':
-            --i; // a first digit is a part of op's argument
-            return Op::SET;
-        case '+':
-            return Op::ADD;
-        case '-':
-            return Op::SUB;
-        case '*':
-            return Op::MUL;
-        case '/':
-            return Op::DIV;
-        case '%':
-            return Op::REM;
-        case '_':
-            return Op::NEG;
-        case '^':
-            return Op::POW;
-        case 'S': // sqrt, sin
-            switch (line[i++]) {
-                case 'Q':
-                    switch (line[i++]) {
-                        case 'R':
-                            switch (line[i++]) {
-                                case 'T':
-                                    return Op::SQRT;
-                                default:
-                                    return rollback(4);
-                            }
-                        default:
-                            return rollback(3);
-                    }
-                case 'I':
-                    switch (line[i++]) {
-                        case 'N':
-                            return Op::SIN;
-                        default:
-                            return rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        case 'C': // cos
-            switch (line[i++]) {
-                case 'O':
-                    switch (line[i++]) {
-                        case 'S':
-                            return Op::COS;
-                        default:
-                            return rollback(3);
-                    }
-                case 'T':
-                    switch (line[i++]) {
-                        case 'N':
-                            return Op::CTN;
-                        default:
-                            rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        case 'T':  // tan
-            switch (line[i++]) {
-                case 'A':
-                    switch (line[i++]) {
-                        case 'N':
-                            return Op::TAN;
-                        default:
-                            return rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        case 'A':  // acos, asin, atan, actn
-            switch (line[i++]) {
-                case 'S':
-                    switch (line[i++]) {
-                        case 'I':
-                            switch (line[i++]) {
-                                case 'N':
-                                    return Op::ASIN;
-                                default:
-                                    return rollback(4);
-                            }
-                        default:
-                            return rollback(3);
-                    }
-                case 'C':
-                    switch (line[i++]) {
-                        case 'O':
-                            switch (line[i++]) {
-                                case 'S':
-                                    return Op::ACOS;
-                                default:
-                                    return rollback(4);
-                            }
-                        case 'T':
-                            switch (line[i++]) {
-                                case 'N':
-                                    return Op::ACTN;
-                                default:
-                                    return rollback(4);
-                            }
-                        default:
-                            return rollback(3);
-                    }
-                case 'T':
-                    switch (line[i++]) {
-                        case 'A':
-                            switch (line[i++]) {
-                                case 'N':
-                                    return Op::ATAN;
-                                default:
-                                    return rollback(4);
-                            }
-                        default:
-                            return rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        case 'R': // rad
-            switch (line[i++]) {
-                case 'A':
-                    switch (line[i++]) {
-                        case 'D':
-                            return Op::RAD;
-                        default:
-                            return rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        case 'D': // deg
-            switch (line[i++]) {
-                case 'E':
-                    switch (line[i++]) {
-                        case 'G':
-                            return Op::DEG;
-                        default:
-                            return rollback(3);
-                    }
-                default:
-                    return rollback(2);
-            }
-        default:
-                return rollback(1);
+    std::string_view name;
+    Op op;
+};
+
+// every name is up to 4 capital letters
+constexpr Mnemonic mnemonics[] = {
+      {"SQRT", Op::SQRT}
+    , {"SIN", Op::SIN}
+    , {"COS", Op::COS}
+    , {"TAN", Op::TAN}
+    , {"CTN", Op::CTN}
+    , {"ASIN", Op::ASIN}
+    , {"ACOS", Op::ACOS}
+    , {"ATAN", Op::ATAN}
+    , {"ACTN", Op::ACTN}
+    , {"LN", Op::LN}
+    , {"LOG", Op::LOG}
+    , {"EXP", Op::EXP}
+    , {"RAD", Op::RAD}
+    , {"DEG", Op::DEG}
+    , {"STO", Op::STO}
+    , {"RCL", Op::RCL}
+};
+
+constexpr std::array<Op, 256> make_char_ops()
+{
+    std::array<Op, 256> ops{};
+    for (char c = '0'; c <= '9'; ++c) {
+        ops[static_cast<unsigned char>(c)] = Op::SET;
     }
+    ops['+'] = Op::ADD;
+    ops['-'] = Op::SUB;
+    ops['*'] = Op::MUL;
+    ops['/'] = Op::DIV;
+    ops['%'] = Op::REM;
+    ops['_'] = Op::NEG;
+    ops['^'] = Op::POW;
+    return ops;
 }
 
-std::size_t skip_ws(const std::string & line, std::size_t i)
+// operations written as a single character, by their first one
+constexpr std::array<Op, 256> char_ops = make_char_ops();
+
+// first letters of a mnemonic packed into a word, the same on any byte order
+constexpr std::uint32_t pack(const std::string_view name, const std::size_t length)
+{
+    std::uint32_t word = 0;
+    for (std::size_t k = 0; k < length; ++k) {
+        word |= static_cast<std::uint32_t>(static_cast<unsigned char>(name[k])) << (8 * k);
+    }
+    return word;
+}
+
+    const unsigned mnemonic_hash_bits = 5;
+
+constexpr std::size_t mnemonic_hash(const std::uint32_t word, const std::uint32_t multiplier)
+{
+    return (word * multiplier) >> (32 - mnemonic_hash_bits);
+}
+
+// the first multiplier which puts every mnemonic into its own slot
+constexpr std::uint32_t find_multiplier()
+{
+    for (std::uint32_t multiplier = 0x9E3779B1;; multiplier += 2) {
+        std::array<bool, 1 << mnemonic_hash_bits> used{};
+        bool collision = false;
+        for (const auto & mnemonic : mnemonics) {
+            const auto slot = mnemonic_hash(pack(mnemonic.name, mnemonic.name.size()), multiplier);
+            collision = collision || used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return multiplier;
+        }
+    }
+}
+
+    const std::uint32_t mnemonic_multiplier = find_multiplier();
+
+struct MnemonicSlot
+{
+    std::uint32_t word = 0;
+    Op op = Op::ERR;
+};
+
+constexpr std::array<MnemonicSlot, 1 << mnemonic_hash_bits> make_mnemonic_table()
+{
+    std::array<MnemonicSlot, 1 << mnemonic_hash_bits> table{};
+    for (const auto & mnemonic : mnemonics) {
+        const auto word = pack(mnemonic.name, mnemonic.name.size());
+        auto & slot = table[mnemonic_hash(word, mnemonic_multiplier)];
+        slot.word = word;
+        slot.op = mnemonic.op;
+    }
+    return table;
+}
+
+constexpr std::array<MnemonicSlot, 1 << mnemonic_hash_bits> mnemonic_table = make_mnemonic_table();
+
+Op parse_op(std::string_view line, std::size_t & i)
+{
+    const auto op = char_ops[static_cast<unsigned char>(i < line.size() ? line[i] : '\0')];
+    if (op != Op::ERR) {
+        // a first digit is a part of op's argument
+        i += op != Op::SET;
+        return op;
+    }
+    // a mnemonic is a run of capital letters, words like RADIANS resolve to their longest known prefix
+    std::size_t letters = 0;
+    while (letters < 4 && i + letters < line.size() && 'A' <= line[i + letters] && line[i + letters] <= 'Z') {
+        ++letters;
+    }
+    const auto word = pack(line.substr(i), letters);
+    for (std::size_t length = letters; length >= 2; --length) {
+        const auto prefix = length == 4 ? word : word & ((std::uint32_t(1) << (8 * length)) - 1);
+        const auto & slot = mnemonic_table[mnemonic_hash(prefix, mnemonic_multiplier)];
+        if (slot.word == prefix) {
+            i += length;
+            return slot.op;
+        }
+    }
+    return Op::ERR;
+}
+
+std::size_t skip_ws(std::string_view line, std::size_t i)
 {
     while (i < line.size() && std::isspace(line[i])) {
         ++i;
@@ -242,111 +222,300 @@ std::size_t skip_ws(const std::string & line, std::size_t i)
     return i;
 }
 
-double parse_arg(const std::string & line, std::size_t & i)
+// 10^k up to the largest one exactly representable in long double
+constexpr long double powers_of_ten[] = {
+      1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L
+    , 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+
+// the largest power of ten exactly representable in a floating point type, 5^k has to fit into its digits
+template <class Number>
+constexpr int max_exact_power()
+{
+    int power = 0;
+    for (std::uint64_t five = 5; power < 27 && five < (std::uint64_t(1) << std::min(std::numeric_limits<Number>::digits, 63)); five *= 5) {
+        ++power;
+    }
+    return power;
+}
+
+static_assert(max_exact_power<double>() == 22);
+
+bool is_digit(const char c)
+{
+    return '0' <= c && c <= '9';
+}
+
+/**
+ * A numeric argument as it was read: its digits with decimal points and
+ * up to 19 first significant ones gathered into an integer
+ */
+struct Literal
 {
-    double res = 0;
-    std::size_t count = 0;
-    bool good = true;
+    std::size_t begin = 0, end = 0;
+    std::uint64_t mantissa = 0;
+    // of the last digit in the mantissa
+    int exponent = 0;
+    // the one after the digits, clamped
+    int written_exponent = 0;
+    // whether the mantissa holds all the significant digits
+    bool exact = true;
+};
+
+/**
+ * Reads digits with an optional decimal point, up to format.max_digits of them,
+ * and if allowed an exponent
+ */
+Literal scan_arg(std::string_view line, std::size_t & i, const ArgumentFormat & format)
+{
+    Literal literal;
+    literal.begin = i;
+    std::size_t count = 0, significant = 0;
     bool integer = true;
-    double fraction = 1;
-    while (good && i < line.size() && count < max_decimal_digits) {
-        switch (line[i]) {
-            case '0': [[fallthrough]];
-            case '1': [[fallthrough]];
-            case '2': [[fallthrough]];
-            case '3': [[fallthrough]];
-            case '4': [[fallthrough]];
-            case '5': [[fallthrough]];
-            case '6': [[fallthrough]];
-            case '7': [[fallthrough]];
-            case '8': [[fallthrough]];
-            case '9':
-                if (integer) {
-                    res *= 10;
-                    res += line[i] - '0';
-                }
-                else {
-                    fraction /= 10;
-                    res += (line[i] - '0') * fraction;
-                }
-                ++i;
-                ++count;
-                break;
-            case '.':
-                integer = false;
-                ++i;
-                break;
-            default:
-                good = false;
-                break;
+    while (i < line.size() && (format.max_digits == 0 || count < format.max_digits)) {
+        const char c = line[i];
+        if (is_digit(c)) {
+            if (significant < 19) {
+                literal.mantissa = literal.mantissa * 10 + (c - '0');
+                significant += literal.mantissa != 0;
+                literal.exponent -= !integer;
+            }
+            else {
+                literal.exact = false;
+            }
+            ++count;
+        }
+        else if (c == '.') {
+            integer = false;
+        }
+        else {
+            break;
+        }
+        ++i;
+    }
+    literal.end = i;
+
+    if (format.exponent && count > 0 && i < line.size() && (line[i] == 'e' || line[i] == 'E')) {
+        std::size_t j = i + 1;
+        const bool negative = j < line.size() && line[j] == '-';
+        j += j < line.size() && (line[j] == '-' || line[j] == '+');
+        if (j < line.size() && is_digit(line[j])) {
+            int written_exponent = 0;
+            for (; j < line.size() && is_digit(line[j]); ++j) {
+                written_exponent = std::min(written_exponent * 10 + (line[j] - '0'), 99999);
+            }
+            literal.written_exponent = negative ? -written_exponent : written_exponent;
+            literal.exponent += literal.written_exponent;
+            i = j;
         }
     }
-    if (i < line.size()) {
-        std::cerr << "Argument isn't fully parsed, suffix left: '" << line.substr(i) << "'" << std::endl;
+    return literal;
+}
+
+/**
+ * A correctly rounded value of a floating point type: a mantissa exactly
+ * representable in it with an exactly representable power of ten give it
+ * in one multiplication or division, the rest go through std::from_chars
+ */
+template <class Number>
+Number to_number(std::string_view line, const Literal & literal)
+{
+    const int max_power = max_exact_power<Number>();
+    const bool small_mantissa = std::numeric_limits<Number>::digits >= 64
+            || literal.mantissa <= (std::uint64_t(1) << std::min(std::numeric_limits<Number>::digits, 63));
+    Number res = 0;
+    if (literal.exact && small_mantissa && -max_power <= literal.exponent && literal.exponent <= max_power) {
+        res = literal.exponent >= 0
+                ? static_cast<Number>(literal.mantissa) * static_cast<Number>(powers_of_ten[literal.exponent])
+                : static_cast<Number>(literal.mantissa) / static_cast<Number>(powers_of_ten[-literal.exponent]);
+    }
+    else if (literal.mantissa != 0) {
+        // digits are copied without the extra decimal points the scan skips
+        std::string text;
+        for (std::size_t k = literal.begin, point = 0; k < literal.end; ++k) {
+            if (line[k] != '.' || point++ == 0) {
+                text += line[k];
+            }
+        }
+        text += 'e';
+        text += std::to_string(literal.written_exponent);
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), res);
+        if (ec == std::errc::result_out_of_range) {
+            res = literal.written_exponent > 0 ? std::numeric_limits<Number>::infinity() : 0;
+        }
     }
     return res;
 }
 
-double unary(const double current, const Op op, const bool rad_on)
+// every digit is taken at its place rather than only the first 19 ones
+template <>
+Decimal to_number<Decimal>(std::string_view line, const Literal & literal)
 {
-    auto ConvToDegSmart = [=] (double _x) {
+    const auto text = line.substr(literal.begin, literal.end - literal.begin);
+    const auto point = text.find('.');
+    int fraction = 0;
+    for (std::size_t k = point == std::string_view::npos ? text.size() : point; k < text.size(); ++k) {
+        fraction += is_digit(text[k]);
+    }
+    return Decimal::from_digits(text, literal.written_exponent - fraction);
+}
+
+template <class Number>
+Number parse_arg(std::string_view line, std::size_t & i, const ArgumentFormat & format)
+{
+    const auto literal = scan_arg(line, i, format);
+    return to_number<Number>(line, literal);
+}
+
+template <class Number>
+Op parse_line(std::string_view line, Number & arg, const ArgumentFormat & format, Status & status, std::size_t & position)
+{
+    std::size_t i = 0;
+    const auto op = parse_op(line, i);
+    arg = 0;
+    if (op == Op::ERR) {
+        status = status | Status::UnknownOperation;
+        position = 0;
+    }
+    else if (arity(op) == 2) {
+        i = skip_ws(line, i);
+        arg = parse_arg<Number>(line, i, format);
+        if (i < line.size()) {
+            status = status | Status::UnparsedSuffix;
+            position = i;
+        }
+    }
+    return op;
+}
+
+/**
+ * Functions of other number types than the standard ones are found
+ * by argument dependent lookup, like those of Decimal
+ */
+template <class Number>
+Number unary(const Number current, const Op op, const bool rad_on, Status & status)
+{
+    using std::sqrt, std::sin, std::cos, std::tan, std::asin, std::acos, std::atan, std::log, std::log10, std::exp;
+
+    auto ConvToDegSmart = [=] (Number _x) {
         return (rad_on ? (_x) : RadToDeg(_x));
     };
-    auto ConvToRadSmart = [=] (double _x) {
-        return (rad_on ? (_x) : DegToRad(_x));
-    };
 
     switch (op) {
         case Op::NEG:
             return -current;
         case Op::SQRT:
             if (current >= 0) {
-                return std::sqrt(current);
+                return sqrt(current);
             }
             else {
-                std::cerr << "Bad argument for SQRT: " << current << std::endl;
+                status = status | Status::BadArgument;
                 return current;
             }
         case Op::SIN:
-            return std::sin(ConvToRadSmart(current));
+            return rad_on ? sin(current) : trig::sin_deg(current);
         case Op::COS:
-            return std::cos(ConvToRadSmart(current));
+            return rad_on ? cos(current) : trig::cos_deg(current);
         case Op::TAN:
-            return std::tan(ConvToRadSmart(current));
+            return rad_on ? tan(current) : trig::tan_deg(current);
         case Op::CTN:
-            return 1 / std::tan(ConvToRadSmart(current));
+            return Number(1) / (rad_on ? tan(current) : trig::tan_deg(current));
         case Op::ASIN:
             if (-1 <= current && current <= 1) {
-                return (ConvToDegSmart(std::asin(current)));
+                return (ConvToDegSmart(asin(current)));
             }
             else {
-                std::cerr << "Bad argument for ASIN: " << current << "\n";
+                status = status | Status::BadArgument;
                 return current;
             }
         case Op::ACOS:
             if (-1 <= current && current <= 1) {
-                return (ConvToDegSmart(std::acos(current)));
+                return (ConvToDegSmart(acos(current)));
             }
             else {
-                std::cerr << "Bad argument for ACOS: " << current << "\n";
+                status = status | Status::BadArgument;
                 return current;
             }
         case Op::ATAN:
-            return (ConvToDegSmart(std::atan(current)));
-        case Op::ACTN:
-            double angle;
+            return (ConvToDegSmart(atan(current)));
+        case Op::ACTN: {
+            Number angle;
             if (current == 0)
-                angle = M_PI / 2;
+                angle = pi<Number> / Number(2);
             else
-                angle = std::atan(1 / current) + (current < 0 ? M_PI : 0.);
+                angle = atan(Number(1) / current) + (current < 0 ? pi<Number> : Number(0));
             return (ConvToDegSmart(angle));
+        }
+        case Op::LN:
+            if (current > 0) {
+                return log(current);
+            }
+            else {
+                status = status | Status::BadArgument;
+                return current;
+            }
+        case Op::LOG:
+            if (current > 0) {
+                return log10(current);
+            }
+            else {
+                status = status | Status::BadArgument;
+                return current;
+            }
+        case Op::EXP:
+            return exp(current);
         default:
             return current;
     }
 }
 
-double binary(const Op op, const double left, const double right)
+struct MemoEntry
+{
+    std::uint64_t bits = 0;
+    Op op = Op::ERR; // never stored, so marks an empty entry
+    bool rad_on = false;
+    double value = 0;
+};
+
+    const unsigned memo_bits = 8;
+
+// results of recent trigonometric lines, every thread has its own ones
+thread_local std::array<MemoEntry, 1 << memo_bits> memo;
+
+/**
+ * Same as unary, but trigonometric functions of doubles are looked up
+ * in a direct-mapped cache by the operation, the argument and the angle mode,
+ * so repeated lines cost a single comparison; results with problems aren't stored
+ */
+template <class Number>
+Number memoized_unary(const Number current, const Op op, const bool rad_on, Status & status)
+{
+    if constexpr (std::is_same_v<Number, double>) {
+        if (Op::SIN <= op && op <= Op::ACTN) {
+            // the bits rather than the value, so that -0 and NaN are told apart
+            std::uint64_t bits;
+            std::memcpy(&bits, &current, sizeof(bits));
+            const std::uint64_t key = bits ^ (static_cast<std::uint64_t>(op) << 1 | rad_on);
+            auto & entry = memo[(key * 0x9E3779B97F4A7C15) >> (64 - memo_bits)];
+            if (entry.bits == bits && entry.op == op && entry.rad_on == rad_on) {
+                return entry.value;
+            }
+            const Status before = status;
+            const double res = unary(current, op, rad_on, status);
+            if (status == before) {
+                entry = {bits, op, rad_on, res};
+            }
+            return res;
+        }
+    }
+    return unary(current, op, rad_on, status);
+}
+
+template <class Number>
+Number binary(const Op op, const Number left, const Number right, Status & status)
 {
+    using std::remainder, std::pow;
+
     switch (op) {
         case Op::SET:
             return right;
@@ -361,30 +530,32 @@ double binary(const Op op, const double left, const double right)
                 return left / right;
             }
             else {
-                std::cerr << "Bad right argument for division: " << right << std::endl;
+                status = status | Status::DivisionByZero;
                 return left;
             }
         case Op::REM:
             if (right != 0) {
-                return std::remainder(left, right);
+                return remainder(left, right);
             }
             else {
-                std::cerr << "Bad right argument for remainder: " << right << std::endl;
+                status = status | Status::RemainderByZero;
                 return left;
             }
         case Op::POW:
-            return std::pow(left, right);
+            return pow(left, right);
+        case Op::STO: [[fallthrough]];
+        case Op::RCL:
+            // handled by CalcSession, which has registers
+            status = status | Status::NoRegisters;
+            return left;
         default:
             return left;
     }
 }
 
-} // anonymous namespace
-
-double process_line(const double current, bool & rad_on, const std::string & line)
+template <class Number>
+Number evaluate(const Op op, const Number current, const Number arg, bool & rad_on, Status & status)
 {
-    std::size_t i = 0;
-    const auto op = parse_op(line, i);
     switch (op) {
         case Op::RAD:
             rad_on = true;
@@ -394,14 +565,661 @@ double process_line(const double current, bool & rad_on, const std::string & lin
             break;
         default:
             switch (arity(op)) {
-                case 2: {
-                    i = skip_ws(line, i);
-                    const auto arg = parse_arg(line, i);
-                    return binary(op, current, arg);
-                }
-                case 1: return unary(current, op, rad_on);
+                case 2: return binary(op, current, arg, status);
+                case 1: return memoized_unary(current, op, rad_on, status);
                 default: break;
             }
     }
     return current;
 }
+
+std::string_view op_name(const Op op)
+{
+    for (const auto & mnemonic : mnemonics) {
+        if (mnemonic.op == op) {
+            return mnemonic.name;
+        }
+    }
+    return {};
+}
+
+/**
+ * Writes a message for every problem of a line, value is the one the operation was applied to
+ */
+template <class Number>
+void report(std::ostream & out, const Status status, const Op op, const Number value, const Number arg,
+        std::string_view line, const std::size_t position)
+{
+    if (has_status(status, Status::UnknownOperation)) {
+        out << "Unknown operation " << line << '\n';
+    }
+    if (has_status(status, Status::UnparsedSuffix)) {
+        out << "Argument isn't fully parsed, suffix left: '" << line.substr(position) << "'\n";
+    }
+    if (has_status(status, Status::BadArgument)) {
+        out << "Bad argument for " << op_name(op) << ": " << value << '\n';
+    }
+    if (has_status(status, Status::DivisionByZero)) {
+        out << "Bad right argument for division: " << arg << '\n';
+    }
+    if (has_status(status, Status::RemainderByZero)) {
+        out << "Bad right argument for remainder: " << arg << '\n';
+    }
+    if (has_status(status, Status::BadRegister)) {
+        out << "Bad register: " << arg << '\n';
+    }
+    if (has_status(status, Status::NoRegisters)) {
+        out << "Registers are only available in a session\n";
+    }
+}
+
+// evaluates an operation of a compiled program, its problems are recorded for the line at index
+double checked(const Op op, const double current, const double arg, bool & rad_on, Diagnostics * problems,
+        const std::size_t index)
+{
+    Status status = Status::Ok;
+    const double res = evaluate(op, current, arg, rad_on, status);
+    if (status != Status::Ok && problems != nullptr) {
+        problems->push_back({index, {res, status, 0}});
+    }
+    return res;
+}
+
+    // lines per thread below which a parallel replay doesn't pay off
+    const std::size_t min_parallel_chunk = 1 << 12;
+    // affine runs up to this length are evaluated right away rather than skipped and replayed later
+    const std::size_t max_replayed_run = 16;
+
+/**
+ * Value of a run of affine lines which doesn't depend on its entry value: it is only known
+ * once a SET is met, then it is computed by the same operations in the same order as
+ * a sequential replay does, so it is exactly the same. A run without a SET can't be
+ * skipped, as composing its lines into a * x + b rounds differently.
+ */
+struct Affine
+{
+    double value = 0;
+    bool reset = false;
+
+    static bool is_affine(const Op op, const double arg)
+    {
+        switch (op) {
+            case Op::DIV: return arg != 0;
+            case Op::ERR: [[fallthrough]];
+            case Op::SET: [[fallthrough]];
+            case Op::ADD: [[fallthrough]];
+            case Op::SUB: [[fallthrough]];
+            case Op::MUL: [[fallthrough]];
+            case Op::NEG: [[fallthrough]];
+            case Op::RAD: [[fallthrough]];
+            case Op::DEG: return true;
+            default: return false;
+        }
+    }
+
+    void push(const Op op, const double arg)
+    {
+        if (op == Op::SET) {
+            value = arg;
+            reset = true;
+        }
+        if (!reset) {
+            return;
+        }
+        switch (op) {
+            case Op::ADD: value += arg; break;
+            case Op::SUB: value -= arg; break;
+            case Op::MUL: value *= arg; break;
+            case Op::DIV: value /= arg; break;
+            case Op::NEG: value = -value; break;
+            default: break;
+        }
+    }
+};
+
+/**
+ * Affine run of a script chunk ended by a line which needs the actual value
+ */
+struct Segment
+{
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    Affine map;
+    // -1 if the mode isn't changed by the run
+    int mode = -1;
+    // index of the first line of the run
+    std::size_t begin = 0;
+    // index of the line ending the run
+    std::size_t barrier = none;
+    std::size_t end = 0;
+    // the value the run starts from, and whether its lines are left to the parallel replay
+    double entry = 0;
+    bool skipped = false;
+};
+
+template <class F>
+void parallel_for(const std::size_t threads, F && f)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(f, t);
+    }
+    f(0);
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
+} // anonymous namespace
+
+template <class Number>
+BasicResult<Number> evaluate_line(const typename NumberTag<Number>::type current, bool & rad_on, std::string_view line,
+        const ArgumentFormat & format)
+{
+    BasicResult<Number> result;
+    std::size_t position = 0;
+    Number arg;
+    const auto op = parse_line(line, arg, format, result.status, position);
+    result.value = evaluate(op, current, arg, rad_on, result.status);
+    result.position = static_cast<std::uint32_t>(position);
+    return result;
+}
+
+template BasicResult<float> evaluate_line<float>(float, bool &, std::string_view, const ArgumentFormat &);
+template BasicResult<double> evaluate_line<double>(double, bool &, std::string_view, const ArgumentFormat &);
+template BasicResult<long double> evaluate_line<long double>(long double, bool &, std::string_view, const ArgumentFormat &);
+template BasicResult<Decimal> evaluate_line<Decimal>(Decimal, bool &, std::string_view, const ArgumentFormat &);
+
+Result evaluate_line(const double current, bool & rad_on, std::string_view line, const ArgumentFormat & format)
+{
+    return evaluate_line<double>(current, rad_on, line, format);
+}
+
+void describe(std::ostream & out, std::string_view line, const Result & result, const ArgumentFormat & format)
+{
+    Status status = Status::Ok;
+    std::size_t position = 0;
+    double arg;
+    const auto op = parse_line(line, arg, format, status, position);
+    report(out, result.status, op, result.value, arg, line, result.position);
+}
+
+double process_line(const double current, bool & rad_on, std::string_view line, const ArgumentFormat & format)
+{
+    Status status = Status::Ok;
+    std::size_t position = 0;
+    double arg;
+    const auto op = parse_line(line, arg, format, status, position);
+    const double res = evaluate(op, current, arg, rad_on, status);
+    if (status != Status::Ok) {
+        report(std::cerr, status, op, current, arg, line, position);
+    }
+    return res;
+}
+
+Diagnostics process_line_batch(double * registers, const std::size_t count, bool & rad_on, std::string_view line,
+        const ArgumentFormat & format)
+{
+    Status status = Status::Ok;
+    std::size_t position = 0;
+    double arg;
+    const auto op = parse_line(line, arg, format, status, position);
+    Diagnostics problems;
+    if (status != Status::Ok) {
+        problems.push_back({Diagnostic::whole_line, {0, status, static_cast<std::uint32_t>(position)}});
+    }
+    const auto whole_line = [&] {
+        checked(op, 0, arg, rad_on, &problems, Diagnostic::whole_line);
+    };
+
+    // registers out of the domain are recorded one by one and restored afterwards
+    const auto keep_if = [&] (const auto out_of_domain) {
+        for (std::size_t k = 0; k < count; ++k) {
+            if (out_of_domain(registers[k])) {
+                problems.push_back({k, {registers[k], Status::BadArgument, 0}});
+            }
+        }
+    };
+    const auto to_degrees = [&] {
+        if (!rad_on) {
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = RadToDeg(registers[k]);
+            }
+        }
+    };
+
+    switch (op) {
+        case Op::RAD:
+            rad_on = true;
+            break;
+        case Op::DEG:
+            rad_on = false;
+            break;
+        case Op::SET:
+            std::fill(registers, registers + count, arg);
+            break;
+        case Op::ADD:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] += arg;
+            }
+            break;
+        case Op::SUB:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] -= arg;
+            }
+            break;
+        case Op::MUL:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] *= arg;
+            }
+            break;
+        case Op::DIV:
+            if (arg == 0) {
+                whole_line();
+                break;
+            }
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] /= arg;
+            }
+            break;
+        case Op::REM:
+            if (arg == 0) {
+                whole_line();
+                break;
+            }
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = std::remainder(registers[k], arg);
+            }
+            break;
+        case Op::POW:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = std::pow(registers[k], arg);
+            }
+            break;
+        case Op::NEG:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = -registers[k];
+            }
+            break;
+        case Op::SQRT:
+            keep_if([] (const double x) { return !(x >= 0); });
+            vector_math::sqrt(registers, count);
+            break;
+        case Op::SIN:
+            (rad_on ? vector_math::sin : vector_math::sin_deg)(registers, count);
+            break;
+        case Op::COS:
+            (rad_on ? vector_math::cos : vector_math::cos_deg)(registers, count);
+            break;
+        case Op::TAN:
+            (rad_on ? vector_math::tan : vector_math::tan_deg)(registers, count);
+            break;
+        case Op::CTN:
+            (rad_on ? vector_math::tan : vector_math::tan_deg)(registers, count);
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = 1 / registers[k];
+            }
+            break;
+        case Op::ASIN:
+            keep_if([] (const double x) { return !(-1 <= x && x <= 1); });
+            vector_math::asin(registers, count);
+            to_degrees();
+            break;
+        case Op::ACOS:
+            keep_if([] (const double x) { return !(-1 <= x && x <= 1); });
+            vector_math::acos(registers, count);
+            to_degrees();
+            break;
+        case Op::ATAN:
+            vector_math::atan(registers, count);
+            to_degrees();
+            break;
+        case Op::ACTN:
+            vector_math::acot(registers, count);
+            to_degrees();
+            break;
+        case Op::LN: [[fallthrough]];
+        case Op::LOG:
+            keep_if([] (const double x) { return !(x > 0); });
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = op == Op::LN ? std::log(registers[k]) : std::log10(registers[k]);
+            }
+            break;
+        case Op::EXP:
+            for (std::size_t k = 0; k < count; ++k) {
+                registers[k] = std::exp(registers[k]);
+            }
+            break;
+        case Op::STO: [[fallthrough]];
+        case Op::RCL:
+            whole_line();
+            break;
+        default:
+            break;
+    }
+    for (const auto & problem : problems) {
+        if (problem.index != Diagnostic::whole_line) {
+            registers[problem.index] = problem.result.value;
+        }
+    }
+    return problems;
+}
+
+Program Program::compile(const std::string_view script, const ArgumentFormat & format, Diagnostics * problems)
+{
+    Program program;
+    std::size_t begin = 0;
+    while (begin < script.size()) {
+        const auto end = std::min(script.find('\n', begin), script.size());
+        const auto line = script.substr(begin, end - begin);
+        Status status = Status::Ok;
+        std::size_t position = 0;
+        double arg;
+        const auto op = parse_line(line, arg, format, status, position);
+        if (status != Status::Ok && problems != nullptr) {
+            problems->push_back({program.m_code.size(), {0, status, static_cast<std::uint32_t>(position)}});
+        }
+        program.m_code.push_back({static_cast<std::uint8_t>(op), arg});
+        begin = end + 1;
+    }
+    program.m_code.push_back({static_cast<std::uint8_t>(Op::END), 0});
+    return program;
+}
+
+std::size_t Program::size() const
+{
+    return m_code.size() - 1;
+}
+
+double Program::run(const double current, bool & rad_on, double * results, Diagnostics * problems) const
+{
+    return results != nullptr
+            ? execute<true>(current, rad_on, results, problems)
+            : execute<false>(current, rad_on, results, problems);
+}
+
+double Program::run_parallel(const double current, bool & rad_on, double * results, std::size_t threads,
+        Diagnostics * problems) const
+{
+    const std::size_t n = size();
+    threads = std::min(threads, n / min_parallel_chunk);
+    if (threads <= 1) {
+        return run(current, rad_on, results, problems);
+    }
+    const std::size_t chunk = (n + threads - 1) / threads;
+    threads = (n + chunk - 1) / chunk;
+    const auto chunk_end = [n, chunk] (const std::size_t t) {
+        return std::min(n, (t + 1) * chunk);
+    };
+
+    // find affine runs of every chunk on its own thread
+    std::vector<std::vector<Segment>> segments(threads);
+    parallel_for(threads, [&] (const std::size_t t) {
+        Segment segment;
+        segment.begin = t * chunk;
+        for (std::size_t i = t * chunk; i < chunk_end(t); ++i) {
+            const auto op = static_cast<Op>(m_code[i].op);
+            if (!Affine::is_affine(op, m_code[i].arg)) {
+                segment.barrier = i;
+                segment.end = i;
+                segments[t].push_back(segment);
+                segment = Segment();
+                segment.begin = i + 1;
+                continue;
+            }
+            segment.map.push(op, m_code[i].arg);
+            if (op == Op::RAD || op == Op::DEG) {
+                segment.mode = op == Op::RAD;
+            }
+        }
+        segment.end = chunk_end(t);
+        segments[t].push_back(segment);
+    });
+
+    // walk the runs in order, skipping the long ones whose value is known without evaluating them
+    double value = current;
+    for (auto & chunk_segments : segments) {
+        for (auto & segment : chunk_segments) {
+            segment.entry = value;
+            segment.skipped = segment.end - segment.begin > max_replayed_run && segment.map.reset;
+            if (segment.skipped) {
+                value = segment.map.value;
+            }
+            else {
+                for (std::size_t i = segment.begin; i < segment.end; ++i) {
+                    value = checked(static_cast<Op>(m_code[i].op), value, m_code[i].arg, rad_on, problems, i);
+                    if (results != nullptr) {
+                        results[i] = value;
+                    }
+                }
+            }
+            if (segment.mode >= 0) {
+                rad_on = segment.mode;
+            }
+            if (segment.barrier != Segment::none) {
+                const auto & instruction = m_code[segment.barrier];
+                value = checked(static_cast<Op>(instruction.op), value, instruction.arg, rad_on, problems,
+                        segment.barrier);
+                if (results != nullptr) {
+                    results[segment.barrier] = value;
+                }
+            }
+        }
+    }
+    if (results == nullptr) {
+        return value;
+    }
+
+    // replay the skipped runs from their entry values to fill in their results
+    parallel_for(threads, [&] (const std::size_t t) {
+        bool mode = false; // affine lines don't depend on it and have no problems
+        for (const auto & segment : segments[t]) {
+            if (!segment.skipped) {
+                continue;
+            }
+            double replayed = segment.entry;
+            for (std::size_t i = segment.begin; i < segment.end; ++i) {
+                replayed = checked(static_cast<Op>(m_code[i].op), replayed, m_code[i].arg, mode, nullptr, i);
+                results[i] = replayed;
+            }
+        }
+    });
+    return value;
+}
+
+template <bool record>
+double Program::execute(double current, bool & rad_on, double * results, Diagnostics * problems) const
+{
+    const Instruction * ip = m_code.data();
+#define CHECKED(op, arg) checked(op, current, arg, rad_on, problems, static_cast<std::size_t>(ip - m_code.data()))
+#if defined(__GNUC__)
+    // threaded dispatch: every handler ends with its own indirect jump to the next one
+#define HANDLER(name) handle_##name
+#define NEXT() do { if constexpr (record) { *results++ = current; } goto *handlers[(++ip)->op]; } while (false)
+    static const void * const handlers[] = {
+          &&HANDLER(ERR), &&HANDLER(SET), &&HANDLER(ADD), &&HANDLER(SUB), &&HANDLER(MUL)
+        , &&HANDLER(DIV), &&HANDLER(REM), &&HANDLER(NEG), &&HANDLER(POW), &&HANDLER(SQRT)
+        , &&HANDLER(SIN), &&HANDLER(COS), &&HANDLER(TAN), &&HANDLER(CTN), &&HANDLER(ASIN)
+        , &&HANDLER(ACOS), &&HANDLER(ATAN), &&HANDLER(ACTN), &&HANDLER(LN), &&HANDLER(LOG)
+        , &&HANDLER(EXP), &&HANDLER(STO), &&HANDLER(RCL), &&HANDLER(RAD), &&HANDLER(DEG)
+        , &&HANDLER(END)
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<std::size_t>(Op::END) + 1);
+    goto *handlers[ip->op];
+#else
+#define HANDLER(name) case static_cast<std::uint8_t>(Op::name)
+#define NEXT() do { if constexpr (record) { *results++ = current; } ++ip; goto dispatch; } while (false)
+dispatch:
+    switch (ip->op) {
+#endif
+    HANDLER(ERR):
+        NEXT();
+    HANDLER(SET):
+        current = ip->arg;
+        NEXT();
+    HANDLER(ADD):
+        current += ip->arg;
+        NEXT();
+    HANDLER(SUB):
+        current -= ip->arg;
+        NEXT();
+    HANDLER(MUL):
+        current *= ip->arg;
+        NEXT();
+    HANDLER(DIV):
+        current = ip->arg != 0 ? current / ip->arg : CHECKED(Op::DIV, ip->arg);
+        NEXT();
+    HANDLER(REM):
+        current = CHECKED(Op::REM, ip->arg);
+        NEXT();
+    HANDLER(NEG):
+        current = -current;
+        NEXT();
+    HANDLER(POW):
+        current = std::pow(current, ip->arg);
+        NEXT();
+    HANDLER(SQRT):
+        current = CHECKED(Op::SQRT, 0);
+        NEXT();
+    HANDLER(SIN):
+        current = CHECKED(Op::SIN, 0);
+        NEXT();
+    HANDLER(COS):
+        current = CHECKED(Op::COS, 0);
+        NEXT();
+    HANDLER(TAN):
+        current = CHECKED(Op::TAN, 0);
+        NEXT();
+    HANDLER(CTN):
+        current = CHECKED(Op::CTN, 0);
+        NEXT();
+    HANDLER(ASIN):
+        current = CHECKED(Op::ASIN, 0);
+        NEXT();
+    HANDLER(ACOS):
+        current = CHECKED(Op::ACOS, 0);
+        NEXT();
+    HANDLER(ATAN):
+        current = CHECKED(Op::ATAN, 0);
+        NEXT();
+    HANDLER(ACTN):
+        current = CHECKED(Op::ACTN, 0);
+        NEXT();
+    HANDLER(LN):
+        current = CHECKED(Op::LN, 0);
+        NEXT();
+    HANDLER(LOG):
+        current = CHECKED(Op::LOG, 0);
+        NEXT();
+    HANDLER(EXP):
+        current = std::exp(current);
+        NEXT();
+    HANDLER(STO):
+    HANDLER(RCL):
+        current = CHECKED(static_cast<Op>(ip->op), ip->arg);
+        NEXT();
+    HANDLER(RAD):
+        rad_on = true;
+        NEXT();
+    HANDLER(DEG):
+        rad_on = false;
+        NEXT();
+    HANDLER(END):
+        return current;
+#if !defined(__GNUC__)
+        default:
+            return current;
+    }
+#endif
+#undef CHECKED
+#undef NEXT
+#undef HANDLER
+}
+
+double CalcSession::process_line(std::string_view line, const ArgumentFormat & format)
+{
+    m_status = Status::Ok;
+    std::size_t position = 0;
+    double arg;
+    const auto op = parse_line(line, arg, format, m_status, position);
+    switch (op) {
+        case Op::STO: [[fallthrough]];
+        case Op::RCL: {
+            if (!(0 <= arg && arg < register_count) || arg != static_cast<std::size_t>(arg)) {
+                m_status = m_status | Status::BadRegister;
+                break;
+            }
+            auto & reg = m_registers[static_cast<std::size_t>(arg)];
+            if (op == Op::STO) {
+                reg = m_current;
+            }
+            else {
+                m_current = reg;
+            }
+            break;
+        }
+        default:
+            m_current = evaluate(op, m_current, arg, m_rad_on, m_status);
+    }
+    m_errors += m_status != Status::Ok;
+    return m_current;
+}
+
+double CalcSession::value() const
+{
+    return m_current;
+}
+
+double CalcSession::get_register(const std::size_t index) const
+{
+    return m_registers[index];
+}
+
+bool CalcSession::rad_on() const
+{
+    return m_rad_on;
+}
+
+Status CalcSession::status() const
+{
+    return m_status;
+}
+
+std::size_t CalcSession::errors() const
+{
+    return m_errors;
+}
+
+SessionPool::SessionPool(const std::size_t capacity)
+{
+    m_sessions.reserve(capacity);
+    m_free.reserve(capacity);
+}
+
+SessionPool::Id SessionPool::acquire()
+{
+    if (m_free.empty()) {
+        m_sessions.emplace_back();
+        return static_cast<Id>(m_sessions.size() - 1);
+    }
+    const Id id = m_free.back();
+    m_free.pop_back();
+    m_sessions[id] = CalcSession();
+    return id;
+}
+
+void SessionPool::release(const Id id)
+{
+    m_free.push_back(id);
+}
+
+CalcSession & SessionPool::operator [] (const Id id)
+{
+    return m_sessions[id];
+}
+
+std::size_t SessionPool::size() const
+{
+    return m_sessions.size() - m_free.size();
+}
@@ -0,0 +1,316 @@
+#include "decimal.h"
+
+#include <cmath> // for long double math functions
+#include <cstdint>
+#include <ostream>
+
+namespace {
+
+using Raw = Decimal::Raw;
+using Unsigned = unsigned __int128;
+
+    const Raw max_raw = ~Decimal::nan().raw();
+    const Unsigned scale = Decimal::scale;
+
+Unsigned magnitude(const Raw raw)
+{
+    return raw < 0 ? -static_cast<Unsigned>(raw) : static_cast<Unsigned>(raw);
+}
+
+// a magnitude with a sign, not a number when it's out of range
+Decimal make(const Unsigned value, const bool negative)
+{
+    if (value > static_cast<Unsigned>(max_raw)) {
+        return Decimal::nan();
+    }
+    const auto raw = static_cast<Raw>(value);
+    return Decimal::from_raw(negative ? -raw : raw);
+}
+
+/**
+ * A 256-bit number as four 64-bit limbs, the most significant first
+ */
+struct Wide
+{
+    std::uint64_t limbs[4] = {};
+};
+
+Wide multiply(const Unsigned a, const Unsigned b)
+{
+    const Unsigned mask = ~std::uint64_t(0);
+    const Unsigned
+        low = (a & mask) * (b & mask),
+        cross1 = (a & mask) * (b >> 64),
+        cross2 = (a >> 64) * (b & mask),
+        high = (a >> 64) * (b >> 64);
+    const Unsigned middle = (low >> 64) + (cross1 & mask) + (cross2 & mask);
+    const Unsigned top = high + (cross1 >> 64) + (cross2 >> 64) + (middle >> 64);
+    Wide res;
+    res.limbs[0] = static_cast<std::uint64_t>(top >> 64);
+    res.limbs[1] = static_cast<std::uint64_t>(top);
+    res.limbs[2] = static_cast<std::uint64_t>(middle);
+    res.limbs[3] = static_cast<std::uint64_t>(low);
+    return res;
+}
+
+/**
+ * Quotient rounded half away from zero, all ones when it doesn't fit into 128 bits
+ */
+Unsigned divide(const Wide & dividend, const Unsigned divisor)
+{
+    Unsigned quotient = 0, rest = 0;
+    bool overflow = false;
+    if (divisor >> 64 == 0) {
+        // a limb at a time, the rest is always below the divisor, so a step fits into 128 bits
+        for (const std::uint64_t limb : dividend.limbs) {
+            const Unsigned current = (rest << 64) | limb;
+            overflow = overflow || quotient >> 64 != 0;
+            quotient = (quotient << 64) | (current / divisor);
+            rest = current % divisor;
+        }
+    }
+    else {
+        // a bit at a time, the rest stays below the divisor, so shifting it never overflows
+        for (int bit = 255; bit >= 0; --bit) {
+            rest = (rest << 1) | ((dividend.limbs[3 - bit / 64] >> (bit % 64)) & 1);
+            overflow = overflow || quotient >> 127 != 0;
+            quotient <<= 1;
+            if (rest >= divisor) {
+                rest -= divisor;
+                quotient |= 1;
+            }
+        }
+    }
+    if (overflow || quotient == ~Unsigned(0)) {
+        return ~Unsigned(0);
+    }
+    return quotient + (rest >= divisor - rest);
+}
+
+Decimal through_long_double(const Decimal a, long double (*f)(long double))
+{
+    return a.is_nan() ? a : Decimal(f(static_cast<long double>(a)));
+}
+
+} // anonymous namespace
+
+Decimal::Decimal(const long double value)
+{
+    // the largest magnitude is a bit below 2^127 / 10^18
+    if (!(std::fabs(value) < 1.7e20L)) {
+        m_raw = nan_raw;
+        return;
+    }
+    const long double integer = std::trunc(value);
+    m_raw = static_cast<Raw>(integer) * scale + static_cast<Raw>(std::round((value - integer) * 1e18L));
+}
+
+Decimal Decimal::from_digits(const std::string_view text, const int exponent)
+{
+    int count = 0;
+    for (const char c : text) {
+        count += '0' <= c && c <= '9';
+    }
+    // place of the next digit, 0 is the last one kept
+    long place = static_cast<long>(exponent) + fraction_digits + count - 1;
+    Unsigned value = 0;
+    bool round_up = false;
+    for (const char c : text) {
+        if (c < '0' || '9' < c) {
+            continue;
+        }
+        if (place >= 0) {
+            value = value * 10 + (c - '0');
+            if (value > static_cast<Unsigned>(max_raw)) {
+                return nan();
+            }
+        }
+        else if (place == -1) {
+            round_up = c >= '5';
+        }
+        --place;
+    }
+    for (; place >= 0 && value != 0; --place) {
+        value *= 10;
+        if (value > static_cast<Unsigned>(max_raw)) {
+            return nan();
+        }
+    }
+    return make(value + round_up, false);
+}
+
+Decimal::operator long double() const
+{
+    if (is_nan()) {
+        return NAN;
+    }
+    return static_cast<long double>(m_raw / scale) + static_cast<long double>(m_raw % scale) / 1e18L;
+}
+
+Decimal::operator double() const
+{
+    return static_cast<double>(static_cast<long double>(*this));
+}
+
+Decimal operator + (const Decimal a, const Decimal b)
+{
+    Raw sum;
+    if (a.is_nan() || b.is_nan() || __builtin_add_overflow(a.m_raw, b.m_raw, &sum)) {
+        return Decimal::nan();
+    }
+    return Decimal::from_raw(sum);
+}
+
+Decimal operator - (const Decimal a, const Decimal b)
+{
+    return a + -b;
+}
+
+Decimal operator * (const Decimal a, const Decimal b)
+{
+    if (a.is_nan() || b.is_nan()) {
+        return Decimal::nan();
+    }
+    return make(divide(multiply(magnitude(a.m_raw), magnitude(b.m_raw)), scale), (a.m_raw < 0) != (b.m_raw < 0));
+}
+
+Decimal operator / (const Decimal a, const Decimal b)
+{
+    if (a.is_nan() || b.is_nan() || b.m_raw == 0) {
+        return Decimal::nan();
+    }
+    return make(divide(multiply(magnitude(a.m_raw), scale), magnitude(b.m_raw)), (a.m_raw < 0) != (b.m_raw < 0));
+}
+
+Decimal remainder(const Decimal a, const Decimal b)
+{
+    if (a.is_nan() || b.is_nan() || b.m_raw == 0) {
+        return Decimal::nan();
+    }
+    const Raw quotient = a.m_raw / b.m_raw;
+    Raw rest = a.m_raw % b.m_raw;
+    // the truncated quotient is one off the nearest one when the rest is over a half of the divisor
+    const Unsigned twice = 2 * magnitude(rest), divisor = magnitude(b.m_raw);
+    if (twice > divisor || (twice == divisor && quotient % 2 != 0)) {
+        rest += (rest < 0) == (b.m_raw < 0) ? -b.m_raw : b.m_raw;
+    }
+    return Decimal::from_raw(rest);
+}
+
+Decimal pow(const Decimal a, const Decimal b)
+{
+    if (a.is_nan() || b.is_nan()) {
+        return Decimal::nan();
+    }
+    if (b.m_raw % Decimal::scale == 0 && magnitude(b.m_raw / Decimal::scale) <= 128) {
+        auto power = static_cast<int>(magnitude(b.m_raw / Decimal::scale));
+        Decimal res = 1, square = a;
+        for (; power != 0; power >>= 1) {
+            if (power & 1) {
+                res = res * square;
+            }
+            square = square * square;
+        }
+        return b.m_raw < 0 ? 1 / res : res;
+    }
+    return Decimal(std::pow(static_cast<long double>(a), static_cast<long double>(b)));
+}
+
+Decimal sqrt(const Decimal a)
+{
+    return through_long_double(a, std::sqrt);
+}
+
+Decimal sin(const Decimal a)
+{
+    return through_long_double(a, std::sin);
+}
+
+Decimal cos(const Decimal a)
+{
+    return through_long_double(a, std::cos);
+}
+
+Decimal tan(const Decimal a)
+{
+    return through_long_double(a, std::tan);
+}
+
+Decimal asin(const Decimal a)
+{
+    return through_long_double(a, std::asin);
+}
+
+Decimal acos(const Decimal a)
+{
+    return through_long_double(a, std::acos);
+}
+
+Decimal atan(const Decimal a)
+{
+    return through_long_double(a, std::atan);
+}
+
+Decimal log(const Decimal a)
+{
+    return through_long_double(a, std::log);
+}
+
+Decimal log10(const Decimal a)
+{
+    return through_long_double(a, std::log10);
+}
+
+Decimal exp(const Decimal a)
+{
+    return through_long_double(a, std::exp);
+}
+
+std::to_chars_result to_chars(char * first, char * const last, const Decimal value)
+{
+    // sign, 39 digits of the integer part, the point and the fraction
+    char buffer[64];
+    char * end = buffer + sizeof(buffer), * begin = end;
+    if (value.is_nan()) {
+        begin -= 3;
+        begin[0] = 'n';
+        begin[1] = 'a';
+        begin[2] = 'n';
+    }
+    else {
+        const Unsigned raw = magnitude(value.raw());
+        Unsigned integer = raw / scale, fraction = raw % scale;
+        int digits = Decimal::fraction_digits;
+        for (; digits > 0 && fraction % 10 == 0; --digits) {
+            fraction /= 10;
+        }
+        for (; digits > 0; --digits) {
+            *--begin = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        if (begin != end) {
+            *--begin = '.';
+        }
+        do {
+            *--begin = static_cast<char>('0' + integer % 10);
+            integer /= 10;
+        } while (integer != 0);
+        if (value.raw() < 0) {
+            *--begin = '-';
+        }
+    }
+    if (last - first < end - begin) {
+        return {last, std::errc::value_too_large};
+    }
+    for (; begin != end; ++begin) {
+        *first++ = *begin;
+    }
+    return {first, std::errc()};
+}
+
+std::ostream & operator << (std::ostream & out, const Decimal value)
+{
+    char buffer[64];
+    const auto [end, ec] = to_chars(buffer, buffer + sizeof(buffer), value);
+    return out.write(buffer, end - buffer);
+}
@@ -0,0 +1,96 @@
+#include "diagnostics.h"
+
+#include <chrono>
+
+DiagnosticSink::DiagnosticSink(std::ostream & out, const std::size_t max_per_second, const std::size_t capacity,
+        const ArgumentFormat & format)
+    : m_out(out)
+    , m_max_per_second(max_per_second)
+    , m_capacity(capacity)
+    , m_format(format)
+    , m_writer(&DiagnosticSink::run, this)
+{}
+
+DiagnosticSink::~DiagnosticSink()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_ready.notify_one();
+    m_writer.join();
+}
+
+void DiagnosticSink::report(std::string_view line, const Result & result)
+{
+    if (result.status == Status::Ok) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_capacity != 0 && m_queue.size() >= m_capacity) {
+            ++m_dropped;
+            return;
+        }
+        m_queue.push_back({std::string(line), result});
+    }
+    m_ready.notify_one();
+}
+
+void DiagnosticSink::run()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::seconds(1);
+    auto window = Clock::now();
+    std::size_t written = 0, suppressed = 0;
+    const auto next_window = [&] (const Clock::time_point now) {
+        if (now - window < period) {
+            return;
+        }
+        if (suppressed != 0) {
+            m_out << "Suppressed diagnostics for " << suppressed << " lines\n";
+            suppressed = 0;
+        }
+        window = now;
+        written = 0;
+    };
+
+    std::vector<Entry> batch;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        const auto ready = [this] { return m_stop || !m_queue.empty(); };
+        if (suppressed != 0) {
+            // the summary is due at the end of the window even if nothing else comes
+            m_ready.wait_until(lock, window + period, ready);
+        }
+        else {
+            m_ready.wait(lock, ready);
+        }
+        batch.swap(m_queue);
+        suppressed += m_dropped;
+        m_dropped = 0;
+        const bool stop = m_stop;
+        lock.unlock();
+
+        next_window(Clock::now());
+        for (const auto & entry : batch) {
+            next_window(Clock::now());
+            if (m_max_per_second != 0 && written >= m_max_per_second) {
+                ++suppressed;
+                continue;
+            }
+            describe(m_out, entry.line, entry.result, m_format);
+            ++written;
+        }
+        batch.clear();
+        if (stop) {
+            if (suppressed != 0) {
+                m_out << "Suppressed diagnostics for " << suppressed << " lines\n";
+            }
+            m_out.flush();
+            return;
+        }
+        m_out.flush();
+        lock.lock();
+    }
+}
@@ -1,14 +1,263 @@
 #include "calc.h"
+#include "decimal.h"
+#include "diagnostics.h"
 
-#include <iostream>
+#include <charconv> // for std::to_chars
+#include <cstdlib> // for std::strtoul
+#include <cstring> // for std::memchr, std::memmove, std::strcmp
+#include <iostream> // for std::cerr
+#include <optional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-int main()
+#include <unistd.h> // for read, write, isatty
+
+namespace {
+
+    const std::size_t block_size = 1 << 16;
+
+// same as operator<< with default stream settings: %g with 6 significant digits
+template <class Number>
+char * format(char * first, char * last, const Number value)
+{
+    return std::to_chars(first, last, value, std::chars_format::general, 6).ptr;
+}
+
+// decimals are written with all their digits
+char * format(char * first, char * last, const Decimal value)
+{
+    return to_chars(first, last, value).ptr;
+}
+
+/**
+ * Results are collected in a large buffer and written with a single call
+ * when it fills up, after every line for an interactive input and at exit
+ */
+class Output
+{
+public:
+    explicit Output(const bool line_buffered)
+        : m_line_buffered(line_buffered)
+    {}
+
+    ~Output()
+    {
+        flush();
+    }
+
+    template <class Number>
+    void print(const Number value)
+    {
+        if (m_used + max_value_size > sizeof(m_buffer)) {
+            flush();
+        }
+        const char * end = format(m_buffer + m_used, m_buffer + sizeof(m_buffer) - 1, value);
+        m_used = end - m_buffer;
+        m_buffer[m_used++] = '\n';
+        if (m_line_buffered) {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        std::size_t written = 0;
+        while (written < m_used) {
+            const auto n = write(STDOUT_FILENO, m_buffer + written, m_used - written);
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+        m_used = 0;
+    }
+
+private:
+    static const std::size_t max_value_size = 64;
+
+    const bool m_line_buffered;
+    char m_buffer[block_size];
+    std::size_t m_used = 0;
+};
+
+/**
+ * The whole journal is compiled and replayed by several threads,
+ * results are printed once all of them are known, then problems of every line
+ * with parse and evaluation ones combined as the line by line mode reports them
+ */
+void replay_parallel(const std::size_t threads, const std::size_t error_rate)
+{
+    std::string script;
+    while (true) {
+        const std::size_t used = script.size();
+        script.resize(used + block_size);
+        const auto n = read(STDIN_FILENO, script.data() + used, block_size);
+        script.resize(used + (n > 0 ? n : 0));
+        if (n <= 0) {
+            break;
+        }
+    }
+    Diagnostics parsed, evaluated;
+    const auto program = Program::compile(script, {}, &parsed);
+    std::vector<double> results(program.size());
+    bool rad_on = false;
+    program.run_parallel(0, rad_on, results.data(), threads, &evaluated);
+    {
+        Output output(false);
+        for (const double value : results) {
+            output.print(value);
+        }
+    }
+
+    DiagnosticSink sink(std::cerr, error_rate);
+    // both are in order of lines, which are found by walking the script along with them
+    std::size_t index = 0, begin = 0;
+    const auto line = [&] (const std::size_t target) {
+        for (; index < target; ++index) {
+            begin = script.find('\n', begin) + 1;
+        }
+        return std::string_view(script).substr(begin, script.find('\n', begin) - begin);
+    };
+    auto p = parsed.begin(), e = evaluated.begin();
+    while (p != parsed.end() || e != evaluated.end()) {
+        const std::size_t target = std::min(p != parsed.end() ? p->index : Diagnostic::whole_line,
+                e != evaluated.end() ? e->index : Diagnostic::whole_line);
+        Result result;
+        if (p != parsed.end() && p->index == target) {
+            result = p++->result;
+        }
+        if (e != evaluated.end() && e->index == target) {
+            result.value = e->result.value;
+            result.status = result.status | e++->result.status;
+        }
+        sink.report(line(target), result);
+    }
+}
+
+/**
+ * Lines are evaluated one by one as they are read
+ */
+template <class Number>
+void stream(const std::size_t error_rate)
 {
-    double current = 0;
+    Number current = 0;
     bool rad_on = false;
-    for (std::string line; std::getline(std::cin, line); ) {
-        current = process_line(current, rad_on, line);
-        std::cout << current << std::endl;
+    const bool interactive = isatty(STDIN_FILENO);
+    Output output(interactive);
+    // problems are written by another thread, unless a user waits for them after every line
+    std::optional<DiagnosticSink> sink;
+    if (!interactive) {
+        sink.emplace(std::cerr, error_rate);
+    }
+
+    // lines are parsed right in the input buffer, an incomplete one is moved to its beginning
+    std::vector<char> input(block_size);
+    std::size_t begin = 0, end = 0;
+    bool eof = false;
+    while (true) {
+        const char * newline = static_cast<const char *>(std::memchr(input.data() + begin, '\n', end - begin));
+        if (newline != nullptr || (eof && begin < end)) {
+            const std::size_t line_end = newline != nullptr ? newline - input.data() : end;
+            const std::string_view line(input.data() + begin, line_end - begin);
+            const auto result = evaluate_line<Number>(current, rad_on, line);
+            current = result.value;
+            output.print(current);
+            if (result.status != Status::Ok) {
+                // messages show values as doubles
+                const Result problem{static_cast<double>(result.value), result.status, result.position};
+                if (sink) {
+                    sink->report(line, problem);
+                }
+                else {
+                    describe(std::cerr, line, problem);
+                }
+            }
+            begin = newline != nullptr ? line_end + 1 : end;
+            continue;
+        }
+        if (eof) {
+            break;
+        }
+        std::memmove(input.data(), input.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        if (end == input.size()) {
+            input.resize(input.size() * 2);
+        }
+        const auto n = read(STDIN_FILENO, input.data() + end, input.size() - end);
+        if (n <= 0) {
+            eof = true;
+        }
+        else {
+            end += n;
+        }
+    }
+}
+
+int usage(const char * program, const char * problem, const char * argument)
+{
+    std::cerr << program << ": " << problem << " " << argument << "\n"
+              << "Usage: " << program << " [--parallel [threads]] [--error-rate N]"
+                 " [--number float|double|long-double|decimal]\n";
+    return 1;
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    bool parallel = false;
+    std::size_t threads = std::thread::hardware_concurrency();
+    std::size_t error_rate = 0;
+    std::string_view number = "double";
+    for (int k = 1; k < argc; ++k) {
+        if (std::strcmp(argv[k], "--parallel") == 0) {
+            parallel = true;
+            if (k + 1 < argc && '0' <= argv[k + 1][0] && argv[k + 1][0] <= '9') {
+                threads = std::strtoul(argv[++k], nullptr, 10);
+            }
+        }
+        else if (std::strcmp(argv[k], "--error-rate") == 0) {
+            if (k + 1 == argc) {
+                return usage(argv[0], "missing value of", argv[k]);
+            }
+            error_rate = std::strtoul(argv[++k], nullptr, 10);
+        }
+        else if (std::strcmp(argv[k], "--number") == 0) {
+            if (k + 1 == argc) {
+                return usage(argv[0], "missing value of", argv[k]);
+            }
+            number = argv[++k];
+        }
+        else {
+            return usage(argv[0], "unknown argument", argv[k]);
+        }
+    }
+    if (parallel) {
+        if (number != "double") {
+            std::cerr << "Parallel replay is only available for double\n";
+            return 1;
+        }
+        replay_parallel(threads, error_rate);
+        return 0;
+    }
+
+    if (number == "float") {
+        stream<float>(error_rate);
+    }
+    else if (number == "double") {
+        stream<double>(error_rate);
+    }
+    else if (number == "long-double") {
+        stream<long double>(error_rate);
+    }
+    else if (number == "decimal") {
+        stream<Decimal>(error_rate);
+    }
+    else {
+        std::cerr << "Unknown number type " << number << ", expected float, double, long-double or decimal\n";
+        return 1;
     }
 }
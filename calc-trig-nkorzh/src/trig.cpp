@@ -0,0 +1,105 @@
+#include "trig.h"
+#include "decimal.h"
+
+#include <cmath>
+
+namespace trig {
+
+namespace {
+
+template <class Number>
+Number to_radians(const Number degrees)
+{
+    return degrees * (pi<Number> / Number(180));
+}
+
+// the rest of the functions are defined through these ones on [0, 45]
+
+template <class Number>
+Number sin_octant(const Number a)
+{
+    using std::sin, std::sqrt;
+    return a == 0 ? Number(0)
+            : a == 30 ? Number(1) / Number(2)
+            : a == 45 ? sqrt(Number(2)) / Number(2)
+            : sin(to_radians(a));
+}
+
+template <class Number>
+Number cos_octant(const Number a)
+{
+    using std::cos, std::sqrt;
+    return a == 0 ? Number(1)
+            : a == 30 ? sqrt(Number(3)) / Number(2)
+            : a == 45 ? sqrt(Number(2)) / Number(2)
+            : cos(to_radians(a));
+}
+
+/**
+ * The angle modulo 360 in [-180, 180], which the remainder computes exactly,
+ * folded to a in [0, 90]; negative tells whether the angle was below zero,
+ * obtuse whether a is 180 degrees minus its absolute value
+ */
+template <class Number>
+Number fold(const Number degrees, bool & negative, bool & obtuse)
+{
+    using std::remainder;
+    const Number angle = remainder(degrees, Number(360));
+    negative = angle < 0;
+    const Number a = negative ? -angle : angle;
+    obtuse = a > 90;
+    // exact, both are between 90 and 180
+    return obtuse ? Number(180) - a : a;
+}
+
+} // anonymous namespace
+
+template <class Number>
+Number sin_deg(const Number degrees)
+{
+    bool negative, obtuse;
+    const Number a = fold(degrees, negative, obtuse);
+    const Number res = a <= 45 ? sin_octant(a) : cos_octant(Number(90) - a);
+    return (negative ? -res : res) + Number(0);
+}
+
+template <class Number>
+Number cos_deg(const Number degrees)
+{
+    bool negative, obtuse;
+    const Number a = fold(degrees, negative, obtuse);
+    const Number res = a <= 45 ? cos_octant(a) : sin_octant(Number(90) - a);
+    return (obtuse ? -res : res) + Number(0);
+}
+
+template <class Number>
+Number tan_deg(const Number degrees)
+{
+    using std::sqrt, std::tan;
+    bool negative, obtuse;
+    const Number a = fold(degrees, negative, obtuse);
+    const Number res =
+            a == 0 ? Number(0)
+            : a == 30 ? Number(1) / sqrt(Number(3))
+            : a == 45 ? Number(1)
+            : a == 60 ? sqrt(Number(3))
+            : a == 90 ? Number(1) / Number(0)
+            : a < 45 ? tan(to_radians(a))
+            : Number(1) / tan(to_radians(Number(90) - a));
+    return (negative != obtuse ? -res : res) + Number(0);
+}
+
+template float sin_deg<float>(float);
+template float cos_deg<float>(float);
+template float tan_deg<float>(float);
+template double sin_deg<double>(double);
+template double cos_deg<double>(double);
+template double tan_deg<double>(double);
+template long double sin_deg<long double>(long double);
+template long double cos_deg<long double>(long double);
+template long double tan_deg<long double>(long double);
+template Decimal sin_deg<Decimal>(Decimal);
+template Decimal cos_deg<Decimal>(Decimal);
+template Decimal tan_deg<Decimal>(Decimal);
+
+} // namespace trig
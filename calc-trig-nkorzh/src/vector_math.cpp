@@ -0,0 +1,346 @@
+#include "vector_math.h"
+#include "trig.h"
+
+#include <algorithm> // for std::min, std::copy
+#include <cmath> // for std::sqrt, std::abs and scalar fallbacks
+
+namespace vector_math {
+
+namespace {
+
+    // lanes are processed in blocks, so that arguments needing a scalar fallback stay at hand
+    const std::size_t block = 256;
+
+    // rounds to the nearest integer for |x| < 2^51
+    const double round_magic = 0x1.8p52;
+
+    // largest argument the three step Cody-Waite reduction below is exact for
+    const double max_reduced = 0x1p20 * 1.57079632679489655800e+00;
+
+    const double inv_pio2 = 6.36619772367581382433e-01;
+    const double pio2_1 = 1.57079632673412561417e+00;
+    const double pio2_2 = 6.07710050630396597660e-11;
+    const double pio2_3 = 2.02226624871116645580e-21;
+    const double pio2_3t = 8.47842766036889956997e-32;
+
+    const double pi = 3.14159265358979311600e+00;
+    const double pio2_hi = 1.57079632679489655800e+00;
+    const double pio2_lo = 6.12323399573676603587e-17;
+    const double pio4_hi = 7.85398163397448278999e-01;
+
+    // largest angle in degrees whose multiple of 90 nearest to it is exact
+    const double max_reduced_degrees = 0x1p45;
+    const double pi_over_180 = 1.74532925199432954744e-02;
+    const double pi_over_180_lo = 2.94865227087016868684e-19;
+    const double half_sqrt_2 = 7.07106781186547572737e-01;
+    const double half_sqrt_3 = 8.66025403784438596588e-01;
+
+// a - b = s + e exactly
+inline double two_diff(const double a, const double b, double & e)
+{
+    const double s = a - b;
+    const double bb = a - s;
+    e = (a - (s + bb)) + (bb - b);
+    return s;
+}
+
+/**
+ * Reduces x to r = y0 + y1 in [-pi/4, pi/4], returns the quadrant:
+ * x = r + (quadrant + 4k) * pi / 2, quadrant is one of -2, -1, 0, 1, 2
+ */
+inline double reduce(const double x, double & y0, double & y1)
+{
+    const double n = (x * inv_pio2 + round_magic) - round_magic;
+    // n * pio2_i are exact, so are the differences up to the rounding errors kept in e
+    double e2, e3;
+    const double r1 = x - n * pio2_1;
+    const double r2 = two_diff(r1, n * pio2_2, e2);
+    const double r3 = two_diff(r2, n * pio2_3, e3);
+    const double e = (e2 + e3) - n * pio2_3t;
+    y0 = r3 + e;
+    y1 = (r3 - y0) + e;
+    return n - 4 * ((n * 0.25 + round_magic) - round_magic);
+}
+
+// sin(x + y) for |x| <= pi/4, y is a tail of x
+inline double kernel_sin(const double x, const double y)
+{
+    const double S1 = -1.66666666666666324348e-01;
+    const double S2 = 8.33333333332248946124e-03;
+    const double S3 = -1.98412698298579493134e-04;
+    const double S4 = 2.75573137070700676789e-06;
+    const double S5 = -2.50507602534068634195e-08;
+    const double S6 = 1.58969099521155010221e-10;
+    const double z = x * x;
+    const double w = z * z;
+    const double r = S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6);
+    const double v = z * x;
+    return x - ((z * (0.5 * y - v * r) - y) - v * S1);
+}
+
+// cos(x + y) for |x| <= pi/4, y is a tail of x
+inline double kernel_cos(const double x, const double y)
+{
+    const double C1 = 4.16666666666666019037e-02;
+    const double C2 = -1.38888888888741095749e-03;
+    const double C3 = 2.48015872894767294178e-05;
+    const double C4 = -2.75573143513906633035e-07;
+    const double C5 = 2.08757232129817482790e-09;
+    const double C6 = -1.13596475577881948265e-11;
+    const double z = x * x;
+    double w = z * z;
+    const double r = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+    const double hz = 0.5 * z;
+    w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + (z * r - x * y));
+}
+
+// upper half of the significand, its square is exact
+inline double high_part(const double x)
+{
+    const double split = 134217729.0; // 2^27 + 1
+    const double c = x * split;
+    return c - (c - x);
+}
+
+/**
+ * Reduces an angle in degrees to r in [-45, 45] exactly, the nearest multiple
+ * of 90 is subtracted from it without rounding; returns the quadrant like reduce does
+ */
+inline double reduce_degrees(const double x, double & r)
+{
+    const double n = (x * (1.0 / 90) + round_magic) - round_magic;
+    r = x - n * 90;
+    return n - 4 * ((n * 0.25 + round_magic) - round_magic);
+}
+
+/**
+ * sin and cos of r in [-45, 45] degrees, those of multiples of 30 and 45 degrees
+ * are correctly rounded constants
+ */
+inline void sin_cos_degrees(const double r, double & s, double & c)
+{
+    // r * pi / 180 = y0 + y1, the rounding error of the product is found by splitting its factors
+    const double y0 = r * pi_over_180;
+    const double rh = high_part(r), rl = r - rh;
+    const double ch = high_part(pi_over_180), cl = pi_over_180 - ch;
+    const double y1 = (((rh * ch - y0) + rh * cl + rl * ch) + rl * cl) + r * pi_over_180_lo;
+    const double a = std::abs(r);
+    const double sa = a == 30 ? 0.5 : half_sqrt_2;
+    const double ca = a == 30 ? half_sqrt_3 : half_sqrt_2;
+    const bool special = (a == 30) | (a == 45);
+    s = special ? (r < 0 ? -sa : sa) : kernel_sin(y0, y1);
+    c = special ? ca : kernel_cos(y0, y1);
+}
+
+// p(t) / q(t) of asin(x) = x + x * p(x^2) / q(x^2)
+inline double asin_ratio(const double t)
+{
+    const double pS0 = 1.66666666666666657415e-01;
+    const double pS1 = -3.25565818622400915405e-01;
+    const double pS2 = 2.01212532134862925881e-01;
+    const double pS3 = -4.00555345006794114027e-02;
+    const double pS4 = 7.91534994289814532176e-04;
+    const double pS5 = 3.47933107596021167570e-05;
+    const double qS1 = -2.40339491173441421878e+00;
+    const double qS2 = 2.02094576023350569471e+00;
+    const double qS3 = -6.88283971605453293030e-01;
+    const double qS4 = 7.70381505559019352791e-02;
+    const double p = t * (pS0 + t * (pS1 + t * (pS2 + t * (pS3 + t * (pS4 + t * pS5)))));
+    const double q = 1.0 + t * (qS1 + t * (qS2 + t * (qS3 + t * qS4)));
+    return p / q;
+}
+
+// atan(|x|) = atan(c) + atan(z) for a reference point c picked by the range of |x|
+inline double kernel_atan(const double x)
+{
+    const double aT0 = 3.33333333333329318027e-01;
+    const double aT1 = -1.99999999998764832476e-01;
+    const double aT2 = 1.42857142725034663711e-01;
+    const double aT3 = -1.11111104054623557880e-01;
+    const double aT4 = 9.09088713343650656196e-02;
+    const double aT5 = -7.69187620504482999495e-02;
+    const double aT6 = 6.66107313738753120669e-02;
+    const double aT7 = -5.83357013379057348645e-02;
+    const double aT8 = 4.97687799461593236017e-02;
+    const double aT9 = -3.65315727442169155270e-02;
+    const double aT10 = 1.62858201153657823623e-02;
+    const double ax = std::abs(x);
+    const bool small = ax < 0.4375;
+    const double z =
+            small ? x
+            : ax < 0.6875 ? (2.0 * ax - 1.0) / (2.0 + ax)
+            : ax < 1.1875 ? (ax - 1.0) / (ax + 1.0)
+            : ax < 2.4375 ? (ax - 1.5) / (1.0 + 1.5 * ax)
+            : -1.0 / ax;
+    const double hi =
+            ax < 0.6875 ? 4.63647609000806093515e-01
+            : ax < 1.1875 ? 7.85398163397448278999e-01
+            : ax < 2.4375 ? 9.82793723247329054082e-01
+            : 1.57079632679489655800e+00;
+    const double lo =
+            ax < 0.6875 ? 2.26987774529616870924e-17
+            : ax < 1.1875 ? 3.06161699786838301793e-17
+            : ax < 2.4375 ? 1.39033110312309984516e-17
+            : 6.12323399573676603587e-17;
+    const double zz = z * z;
+    const double w = zz * zz;
+    const double s1 = zz * (aT0 + w * (aT2 + w * (aT4 + w * (aT6 + w * (aT8 + w * aT10)))));
+    const double s2 = w * (aT1 + w * (aT3 + w * (aT5 + w * (aT7 + w * aT9))));
+    const double shifted = hi - ((z * (s1 + s2) - lo) - z);
+    return small ? z - z * (s1 + s2) : (x < 0 ? -shifted : shifted);
+}
+
+template <class Kernel, class Fallback>
+void apply(double * values, const std::size_t count, Kernel kernel, Fallback fallback, const double limit = max_reduced)
+{
+    double args[block];
+    for (std::size_t begin = 0; begin < count; begin += block) {
+        const std::size_t n = std::min(block, count - begin);
+        double * out = values + begin;
+        std::copy(out, out + n, args);
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = kernel(args[i]);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            if (std::abs(args[i]) > limit) {
+                out[i] = fallback(args[i]);
+            }
+        }
+    }
+}
+
+template <class Kernel>
+void apply(double * values, const std::size_t count, Kernel kernel)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = kernel(values[i]);
+    }
+}
+
+} // anonymous namespace
+
+void sin(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double y0, y1;
+        const double q = reduce(x, y0, y1);
+        const double s = kernel_sin(y0, y1), c = kernel_cos(y0, y1);
+        const double v = (q == 1) | (q == -1) ? c : s;
+        return (q == 0) | (q == 1) ? v : -v;
+    }, [] (const double x) { return std::sin(x); });
+}
+
+void cos(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double y0, y1;
+        const double q = reduce(x, y0, y1);
+        const double s = kernel_sin(y0, y1), c = kernel_cos(y0, y1);
+        const double v = (q == 1) | (q == -1) ? s : c;
+        return (q == 0) | (q == -1) ? v : -v;
+    }, [] (const double x) { return std::cos(x); });
+}
+
+void tan(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double y0, y1;
+        const double q = reduce(x, y0, y1);
+        const double s = kernel_sin(y0, y1), c = kernel_cos(y0, y1);
+        return (q == 1) | (q == -1) ? -c / s : s / c;
+    }, [] (const double x) { return std::tan(x); });
+}
+
+// the results are added to zero, so that exact zeros are positive like those of trig
+
+void sin_deg(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double r, s, c;
+        const double q = reduce_degrees(x, r);
+        sin_cos_degrees(r, s, c);
+        const double v = (q == 1) | (q == -1) ? c : s;
+        return ((q == 0) | (q == 1) ? v : -v) + 0.0;
+    }, trig::sin_deg<double>, max_reduced_degrees);
+}
+
+void cos_deg(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double r, s, c;
+        const double q = reduce_degrees(x, r);
+        sin_cos_degrees(r, s, c);
+        const double v = (q == 1) | (q == -1) ? s : c;
+        return ((q == 0) | (q == -1) ? v : -v) + 0.0;
+    }, trig::cos_deg<double>, max_reduced_degrees);
+}
+
+void tan_deg(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        double r, s, c;
+        const double q = reduce_degrees(x, r);
+        sin_cos_degrees(r, s, c);
+        // at 90 + 180k the sign of infinity alternates with k rather than follows that of zero
+        const double pole = q == 1 ? HUGE_VAL : -HUGE_VAL;
+        const double odd = r == 0 ? pole : -c / s;
+        return ((q == 1) | (q == -1) ? odd : s / c) + 0.0;
+    }, trig::tan_deg<double>, max_reduced_degrees);
+}
+
+void asin(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        const double ax = std::abs(x);
+        // |x| < 0.5
+        const double small = x + x * asin_ratio(x * x);
+        // |x| >= 0.5: asin(x) = pi/2 - 2 * asin(sqrt((1 - |x|) / 2))
+        const double t = (1.0 - ax) * 0.5;
+        const double s = std::sqrt(t);
+        const double r = asin_ratio(t);
+        const double near_one = pio2_hi - (2.0 * (s + s * r) - pio2_lo);
+        const double w = high_part(s);
+        const double c = (t - w * w) / (s + w);
+        const double middle = pio4_hi - ((2.0 * s * r - (pio2_lo - 2.0 * c)) - (pio4_hi - 2.0 * w));
+        const double large = ax >= 0.975 ? near_one : middle;
+        return ax < 0.5 ? small : (x < 0 ? -large : large);
+    });
+}
+
+void acos(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        // |x| < 0.5
+        const double small = pio2_hi - (x - (pio2_lo - x * asin_ratio(x * x)));
+        // |x| >= 0.5: acos(x) = 2 * asin(sqrt((1 - |x|) / 2)), mirrored for negative x
+        const double z = (1.0 - std::abs(x)) * 0.5;
+        const double s = std::sqrt(z);
+        const double r = asin_ratio(z);
+        const double negative = pi - 2.0 * (s + (r * s - pio2_lo));
+        const double df = high_part(s);
+        const double c = (z - df * df) / (s + df);
+        const double positive = x == 1 ? 0.0 : 2.0 * (df + (r * s + c));
+        return x <= -0.5 ? negative : (x < 0.5 ? small : positive);
+    });
+}
+
+void atan(double * values, const std::size_t count)
+{
+    apply(values, count, kernel_atan);
+}
+
+void sqrt(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) { return std::sqrt(x); });
+}
+
+void acot(double * values, const std::size_t count)
+{
+    apply(values, count, [] (const double x) {
+        const double angle = kernel_atan(1 / x) + (x < 0 ? pi : 0.);
+        return x == 0 ? pio2_hi : angle;
+    });
+}
+
+} // namespace vector_math
@@ -1,8 +1,15 @@
 #include "calc.h"
+#include "decimal.h"
+#include "diagnostics.h"
 
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
+#include <random>
 #include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -216,7 +223,7 @@ TEST(Calc, tan)
     EXPECT_NEAR(sqrt_3, process_line(60, rad_on, "TAN"), eps);
     EXPECT_NEAR(0, process_line(180, rad_on, "TAN"), eps);
     EXPECT_NEAR(0, process_line(360, rad_on, "TAN"), eps);
-    EXPECT_DOUBLE_EQ(near_inf, process_line(90, rad_on, "TAN"));
+    EXPECT_EQ(HUGE_VAL, process_line(90, rad_on, "TAN"));
     EXPECT_DOUBLE_EQ(0, process_line(0, rad_on, "RAD"));
     ASSERT_TRUE(rad_on);
     EXPECT_NEAR(1, process_line(M_PI_4, rad_on, "TAN"), eps);
@@ -233,7 +240,7 @@ TEST(Calc, tan)
     EXPECT_NEAR(0, process_line(0, rad_on, "TAN"), eps);
     EXPECT_NEAR(0, process_line(180, rad_on, "TAN"), eps);
     EXPECT_NEAR(0, process_line(360, rad_on, "TAN"), eps);
-    EXPECT_DOUBLE_EQ(near_inf, process_line(90, rad_on, "TAN"));
+    EXPECT_EQ(HUGE_VAL, process_line(90, rad_on, "TAN"));
 }
 
 TEST(Calc, ctn)
@@ -260,6 +267,55 @@ TEST(Calc, ctn)
     EXPECT_NEAR(0, process_line(90, rad_on, "CTN"), eps);
 }
 
+TEST(Calc, degrees_exact)
+{
+    bool rad_on = false;
+    EXPECT_EQ(0, process_line(180, rad_on, "SIN"));
+    EXPECT_FALSE(std::signbit(process_line(-180, rad_on, "SIN")));
+    EXPECT_EQ(0.5, process_line(360000000030., rad_on, "SIN"));
+    EXPECT_EQ(-0.5, process_line(-390, rad_on, "SIN"));
+    EXPECT_EQ(half_sqrt_2, process_line(-315, rad_on, "SIN"));
+    EXPECT_EQ(0.5, process_line(60, rad_on, "COS"));
+    EXPECT_EQ(0, process_line(270, rad_on, "COS"));
+    EXPECT_EQ(-half_sqrt_3, process_line(150, rad_on, "COS"));
+    EXPECT_EQ(1, process_line(225, rad_on, "TAN"));
+    EXPECT_EQ(-HUGE_VAL, process_line(-90, rad_on, "TAN"));
+    EXPECT_EQ(-HUGE_VAL, process_line(270, rad_on, "TAN"));
+    EXPECT_EQ(0, process_line(90, rad_on, "CTN"));
+    const double far = 360 * 1e6 + 1e-3;
+    EXPECT_NEAR(std::sin((far - 360 * 1e6) * M_PI / 180), process_line(far, rad_on, "SIN"), 1e-20);
+
+    std::vector<double> registers = {180, -180, 30, 150, 225, 90, -90, 1e20, far};
+    for (const char * line : {"SIN", "COS", "TAN"}) {
+        std::vector<double> batch = registers;
+        process_line_batch(batch.data(), batch.size(), rad_on, line);
+        for (std::size_t k = 0; k < registers.size(); ++k) {
+            const double expected = process_line(registers[k], rad_on, line);
+            EXPECT_EQ(std::signbit(expected), std::signbit(batch[k])) << line << ' ' << registers[k];
+            if (expected != batch[k]) {
+                EXPECT_NEAR(expected, batch[k], 1e-15 * std::max(1., std::abs(expected))) << line << ' ' << registers[k];
+            }
+        }
+    }
+}
+
+TEST(Calc, memoized)
+{
+    bool rad_on = true;
+    for (int k = 0; k < 2; ++k) {
+        EXPECT_TRUE(std::signbit(process_line(-0., rad_on, "SIN")));
+        EXPECT_FALSE(std::signbit(process_line(0, rad_on, "SIN")));
+        EXPECT_NEAR(0.5, process_line(M_PI / 6, rad_on, "SIN"), eps);
+        EXPECT_NEAR(half_sqrt_3, process_line(M_PI / 6, rad_on, "COS"), eps);
+        bool degrees = false;
+        EXPECT_EQ(0.5, process_line(30, degrees, "SIN"));
+        EXPECT_NEAR(std::sin(30), process_line(30, rad_on, "SIN"), eps);
+        testing::internal::CaptureStderr();
+        EXPECT_EQ(2, process_line(2, rad_on, "ASIN"));
+        EXPECT_EQ("Bad argument for ASIN: 2\n", testing::internal::GetCapturedStderr());
+    }
+}
+
 TEST(Calc, asin)
 {
     bool rad_on = false;
@@ -333,3 +389,389 @@ TEST(Calc, actn)
     EXPECT_DOUBLE_EQ(30, process_line(sqrt_3, rad_on, "ACTN"));
     EXPECT_DOUBLE_EQ(120, process_line(-sqrt_3_over_3, rad_on, "ACTN"));
 }
+
+TEST(Program, same_as_process_line)
+{
+    const std::string_view script = "5\n+ 3.5\n* 2\nSIN\nRAD\nCOS\n_\n- 1\n/ 4\n^ 2\nSQRT\n% 0.3\nDEG\nACTN";
+    const auto program = Program::compile(script);
+    ASSERT_EQ(14u, program.size());
+    for (const double start : {0., -2., 17.25}) {
+        bool rad_on = false;
+        std::vector<double> expected;
+        double current = start;
+        for (std::size_t begin = 0; begin < script.size(); ) {
+            const auto end = std::min(script.find('\n', begin), script.size());
+            current = process_line(current, rad_on, script.substr(begin, end - begin));
+            expected.push_back(current);
+            begin = end + 1;
+        }
+        bool compiled_rad_on = false;
+        std::vector<double> results(program.size());
+        EXPECT_EQ(current, program.run(start, compiled_rad_on, results.data()));
+        EXPECT_EQ(expected, results);
+        EXPECT_EQ(rad_on, compiled_rad_on);
+    }
+}
+
+std::string describe(std::string_view line, const Diagnostic & problem)
+{
+    std::ostringstream out;
+    describe(out, line, problem.result);
+    return out.str();
+}
+
+TEST(Program, errors)
+{
+    Diagnostics problems;
+    testing::internal::CaptureStderr();
+    const auto program = Program::compile("fix\n+ 1x\n/ 0", {}, &problems);
+    bool rad_on = false;
+    EXPECT_DOUBLE_EQ(3, program.run(2, rad_on, nullptr, &problems));
+    EXPECT_EQ("", testing::internal::GetCapturedStderr());
+    ASSERT_EQ(3u, problems.size());
+    EXPECT_EQ(0u, problems[0].index);
+    EXPECT_EQ("Unknown operation fix\n", describe("fix", problems[0]));
+    EXPECT_EQ(1u, problems[1].index);
+    EXPECT_EQ("Argument isn't fully parsed, suffix left: 'x'\n", describe("+ 1x", problems[1]));
+    EXPECT_EQ(2u, problems[2].index);
+    EXPECT_EQ("Bad right argument for division: 0\n", describe("/ 0", problems[2]));
+
+    // parallel replay finds the same problems in the same order
+    std::string script;
+    for (int i = 0; i < 50000; ++i) {
+        script += i % 1000 == 999 ? "SQRT\n" : i % 7000 == 3500 ? "/ 0\n" : "- 1\n";
+    }
+    const auto long_program = Program::compile(script);
+    Diagnostics expected;
+    std::vector<double> results(long_program.size());
+    long_program.run(0, rad_on, results.data(), &expected);
+    problems.clear();
+    long_program.run_parallel(0, rad_on, results.data(), 4, &problems);
+    ASSERT_EQ(57u, expected.size());
+    ASSERT_EQ(expected.size(), problems.size());
+    for (std::size_t k = 0; k < problems.size(); ++k) {
+        EXPECT_EQ(expected[k].index, problems[k].index);
+        EXPECT_EQ(expected[k].result.status, problems[k].result.status);
+    }
+}
+
+// parallel values are exactly the same, overflows and NaNs included
+void expect_same_replay(const std::string & script)
+{
+    const auto program = Program::compile(script);
+    bool rad_on = false, parallel_rad_on = false;
+    std::vector<double> expected(program.size()), results(program.size());
+    const double last = program.run(0, rad_on, expected.data());
+    const double parallel_last = program.run_parallel(0, parallel_rad_on, results.data(), 4);
+    EXPECT_EQ(std::isnan(last), std::isnan(parallel_last));
+    EXPECT_TRUE(std::isnan(last) || last == parallel_last);
+    EXPECT_EQ(rad_on, parallel_rad_on);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQ(std::isnan(expected[i]), std::isnan(results[i])) << i;
+        if (!std::isnan(expected[i])) {
+            ASSERT_EQ(expected[i], results[i]) << i;
+            ASSERT_EQ(std::signbit(expected[i]), std::signbit(results[i])) << i;
+        }
+    }
+    // results aren't needed to get the last value
+    bool no_results_rad_on = false;
+    const double no_results_last = program.run_parallel(0, no_results_rad_on, nullptr, 4);
+    EXPECT_TRUE(std::isnan(last) || last == no_results_last);
+}
+
+TEST(Program, parallel)
+{
+    // long affine runs, some of them starting from a SET, between a few lines which need the actual value
+    std::string script;
+    for (int i = 0; i < 50000; ++i) {
+        script += i % 1000 == 999 ? "SIN\n" : i % 5000 == 2500 ? "RAD\n" : i % 2000 == 10 ? "3\n"
+                : i % 3 == 0 ? "* 0.999\n" : i % 3 == 1 ? "+ 1.5\n" : "/ 1.001\n";
+    }
+    expect_same_replay(script);
+
+    // offsets cancel, so any composition of the lines into a single map loses many digits
+    script = "0.123\nSQRT\n";
+    for (int group = 0; group < 6000; ++group) {
+        script += "+ 9999999999\n* 9999999999\n/ 9999999999\n- 9999999999\n";
+        if (group % 8 == 7) {
+            script += "SQRT\n";
+        }
+    }
+    expect_same_replay(script);
+}
+
+TEST(Program, parallel_range)
+{
+    // products of the coefficients underflow though the values never do
+    std::string script = "9999999999\n";
+    for (int i = 0; i < 29; ++i) {
+        script += "* 9999999999\n";
+    }
+    script += "SQRT\n";
+    for (int i = 0; i < 400; ++i) {
+        for (int k = 0; k < 40; ++k) {
+            script += "/ 9999999999\n";
+        }
+        for (int k = 0; k < 40; ++k) {
+            script += "* 9999999999\n";
+        }
+    }
+    script += "SQRT\n";
+    expect_same_replay(script);
+
+    // values overflow to infinities in the middle of composed runs
+    std::mt19937 random(7);
+    const char * lines[] = {"* 9999\n", "* 9999\n", "/ 9999\n", "+ 5\n", "- 7\n", "_\n"};
+    script = "1\n";
+    for (int i = 0; i < 40000; ++i) {
+        script += i % 2000 == 1999 ? "SQRT\n" : lines[random() % 6];
+    }
+    expect_same_replay(script);
+}
+
+TEST_P(CalcFixture, batch)
+{
+    std::vector<double> start;
+    for (int i = -400; i <= 400; ++i) {
+        start.push_back(i * 0.37);
+        start.push_back(i / 401.);
+    }
+    for (const char * line : {"5", "+ 1.5", "- 2", "* 3", "/ 7", "% 2", "_", "^ 3", "SIN", "COS", "TAN", "CTN", "ATAN", "ACTN", "RAD", "DEG"}) {
+        bool rad_on = GetParam(), batch_rad_on = GetParam();
+        std::vector<double> registers = start;
+        process_line_batch(registers.data(), registers.size(), batch_rad_on, line);
+        for (std::size_t k = 0; k < start.size(); ++k) {
+            const double expected = process_line(start[k], rad_on, line);
+            if (expected == registers[k]) {
+                continue;
+            }
+            ASSERT_NEAR(expected, registers[k], 1e-15 * std::max(1., std::abs(expected))) << line << ' ' << start[k];
+        }
+        EXPECT_EQ(rad_on, batch_rad_on);
+    }
+}
+
+TEST_P(CalcFixture, batch_domain)
+{
+    auto param = GetParam();
+    std::vector<double> registers = {0.5, -1, 2, 1};
+    auto problems = process_line_batch(registers.data(), registers.size(), param, "ASIN");
+    ASSERT_EQ(1u, problems.size());
+    EXPECT_EQ(2u, problems[0].index);
+    EXPECT_EQ("Bad argument for ASIN: 2\n", describe("ASIN", problems[0]));
+    EXPECT_NEAR(param ? M_PI / 6 : 30, registers[0], 1e-14);
+    EXPECT_DOUBLE_EQ(param ? -M_PI_2 : -90, registers[1]);
+    EXPECT_DOUBLE_EQ(2, registers[2]);
+    EXPECT_DOUBLE_EQ(param ? M_PI_2 : 90, registers[3]);
+
+    registers = {4, -4, 0};
+    problems = process_line_batch(registers.data(), registers.size(), param, "SQRT");
+    ASSERT_EQ(1u, problems.size());
+    EXPECT_EQ(1u, problems[0].index);
+    EXPECT_EQ("Bad argument for SQRT: -4\n", describe("SQRT", problems[0]));
+    problems = process_line_batch(registers.data(), registers.size(), param, "/ 0");
+    ASSERT_EQ(1u, problems.size());
+    EXPECT_EQ(Diagnostic::whole_line, problems[0].index);
+    EXPECT_EQ("Bad right argument for division: 0\n", describe("/ 0", problems[0]));
+    EXPECT_EQ(std::vector<double>({2, -4, 0}), registers);
+}
+
+TEST(Calc, argument_rounding)
+{
+    bool rad_on = false;
+    EXPECT_EQ(0.1, process_line(0, rad_on, "0.1"));
+    EXPECT_EQ(65.14, process_line(0, rad_on, "65.14"));
+    EXPECT_EQ(0.000000001, process_line(0, rad_on, "0.000000001"));
+    EXPECT_EQ(1.2, process_line(0, rad_on, "+ 1.2"));
+}
+
+TEST(Calc, argument_format)
+{
+    bool rad_on = false;
+    ArgumentFormat format;
+    format.exponent = true;
+    EXPECT_EQ(1500, process_line(0, rad_on, "1.5e3", format));
+    EXPECT_EQ(0.0025, process_line(0, rad_on, "2.5E-3", format));
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(1, process_line(0, rad_on, "1e", format));
+    EXPECT_EQ(15, process_line(0, rad_on, "15e3"));
+    EXPECT_EQ("Argument isn't fully parsed, suffix left: 'e'\nArgument isn't fully parsed, suffix left: 'e3'\n", testing::internal::GetCapturedStderr());
+
+    format.max_digits = 0;
+    EXPECT_EQ(12345678901234567890.5, process_line(0, rad_on, "12345678901234567890.5", format));
+    EXPECT_EQ(HUGE_VAL, process_line(0, rad_on, "1e400", format));
+    format.max_digits = 3;
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(1.23, process_line(0, rad_on, "1.234", format));
+    EXPECT_EQ("Argument isn't fully parsed, suffix left: '4'\n", testing::internal::GetCapturedStderr());
+}
+
+TEST(Calc, logarithms)
+{
+    bool rad_on = false;
+    EXPECT_DOUBLE_EQ(1, process_line(M_E, rad_on, "LN"));
+    EXPECT_DOUBLE_EQ(3, process_line(1000, rad_on, "LOG"));
+    EXPECT_DOUBLE_EQ(1, process_line(0, rad_on, "EXP"));
+    EXPECT_DOUBLE_EQ(M_E, process_line(1, rad_on, "EXP"));
+    testing::internal::CaptureStderr();
+    EXPECT_DOUBLE_EQ(-1, process_line(-1, rad_on, "LN"));
+    EXPECT_DOUBLE_EQ(0, process_line(0, rad_on, "LOG"));
+    EXPECT_EQ("Bad argument for LN: -1\nBad argument for LOG: 0\n", testing::internal::GetCapturedStderr());
+}
+
+TEST(Calc, mnemonic_prefix)
+{
+    bool rad_on = false;
+    EXPECT_DOUBLE_EQ(0, process_line(0, rad_on, "RADIANS"));
+    EXPECT_TRUE(rad_on);
+    EXPECT_DOUBLE_EQ(2, process_line(4, rad_on, "SQRTX"));
+    testing::internal::CaptureStderr();
+    EXPECT_DOUBLE_EQ(7, process_line(7, rad_on, "CT"));
+    EXPECT_DOUBLE_EQ(7, process_line(7, rad_on, "SQR"));
+    EXPECT_DOUBLE_EQ(7, process_line(7, rad_on, "L"));
+    EXPECT_EQ("Unknown operation CT\nUnknown operation SQR\nUnknown operation L\n", testing::internal::GetCapturedStderr());
+}
+
+TEST(Session, registers)
+{
+    CalcSession session;
+    EXPECT_DOUBLE_EQ(5, session.process_line("5"));
+    EXPECT_DOUBLE_EQ(5, session.process_line("STO 1"));
+    EXPECT_DOUBLE_EQ(8, session.process_line("+ 3"));
+    EXPECT_DOUBLE_EQ(8, session.process_line("STO 7"));
+    EXPECT_DOUBLE_EQ(5, session.process_line("RCL 1"));
+    EXPECT_DOUBLE_EQ(8, session.get_register(7));
+    EXPECT_DOUBLE_EQ(0, session.get_register(0));
+    EXPECT_DOUBLE_EQ(0, session.process_line("RCL 0"));
+    session.process_line("RAD");
+    EXPECT_TRUE(session.rad_on());
+    EXPECT_EQ(0u, session.errors());
+
+    testing::internal::CaptureStderr();
+    EXPECT_DOUBLE_EQ(0, session.process_line("STO 8"));
+    EXPECT_EQ(Status::BadRegister, session.status());
+    EXPECT_DOUBLE_EQ(0, session.process_line("RCL 1.5"));
+    EXPECT_EQ(Status::BadRegister, session.status());
+    EXPECT_DOUBLE_EQ(0, session.process_line("fix"));
+    EXPECT_EQ(Status::UnknownOperation, session.status());
+    EXPECT_DOUBLE_EQ(0, session.process_line("SQRT"));
+    EXPECT_EQ(Status::Ok, session.status());
+    EXPECT_EQ("", testing::internal::GetCapturedStderr());
+    EXPECT_EQ(3u, session.errors());
+
+    bool rad_on = false;
+    testing::internal::CaptureStderr();
+    EXPECT_DOUBLE_EQ(2, process_line(2, rad_on, "STO 1"));
+    EXPECT_EQ("Registers are only available in a session\n", testing::internal::GetCapturedStderr());
+}
+
+TEST(Session, pool)
+{
+    SessionPool pool(4);
+    const auto first = pool.acquire(), second = pool.acquire();
+    EXPECT_NE(first, second);
+    pool[first].process_line("1");
+    pool[second].process_line("2");
+    EXPECT_DOUBLE_EQ(1, pool[first].value());
+    EXPECT_DOUBLE_EQ(2, pool[second].value());
+    EXPECT_EQ(2u, pool.size());
+    pool.release(first);
+    EXPECT_EQ(1u, pool.size());
+    const auto third = pool.acquire();
+    EXPECT_EQ(first, third);
+    EXPECT_DOUBLE_EQ(0, pool[third].value());
+    EXPECT_DOUBLE_EQ(2, pool[second].value());
+}
+
+TEST(Diagnostics, result)
+{
+    bool rad_on = false;
+    testing::internal::CaptureStderr();
+    auto result = evaluate_line(-4, rad_on, "SQRT");
+    EXPECT_DOUBLE_EQ(-4, result.value);
+    EXPECT_EQ(Status::BadArgument, result.status);
+    result = evaluate_line(3, rad_on, "/ 0x");
+    EXPECT_DOUBLE_EQ(3, result.value);
+    EXPECT_EQ(Status::UnparsedSuffix | Status::DivisionByZero, result.status);
+    EXPECT_EQ(3u, result.position);
+    result = evaluate_line(3, rad_on, "+ 2");
+    EXPECT_DOUBLE_EQ(5, result.value);
+    EXPECT_EQ(Status::Ok, result.status);
+    EXPECT_EQ("", testing::internal::GetCapturedStderr());
+
+    std::ostringstream out;
+    describe(out, "/ 0x", evaluate_line(3, rad_on, "/ 0x"));
+    describe(out, "ACOS", evaluate_line(2, rad_on, "ACOS"));
+    EXPECT_EQ("Argument isn't fully parsed, suffix left: 'x'\nBad right argument for division: 0\nBad argument for ACOS: 2\n", out.str());
+}
+
+TEST(Diagnostics, sink)
+{
+    std::ostringstream out;
+    {
+        DiagnosticSink sink(out, 2);
+        bool rad_on = false;
+        for (const char * line : {"fix", "+ 1", "SQRT", "ASIN", "LN"}) {
+            sink.report(line, evaluate_line(-3, rad_on, line));
+        }
+    }
+    EXPECT_EQ("Unknown operation fix\nBad argument for SQRT: -3\nSuppressed diagnostics for 2 lines\n", out.str());
+}
+
+namespace {
+
+std::string text(const Decimal value)
+{
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+} // anonymous namespace
+
+TEST(Numbers, decimal)
+{
+    const auto tenth = Decimal::from_digits("1", -1);
+    EXPECT_EQ("0.3", text(tenth + Decimal::from_digits("2", -1)));
+    EXPECT_EQ(Decimal::from_digits("3", -1), tenth + Decimal::from_digits("2", -1));
+    EXPECT_EQ("-12.5", text(Decimal(-25) / 2));
+    EXPECT_EQ("0.333333333333333333", text(Decimal(1) / 3));
+    EXPECT_EQ("0.666666666666666667", text(Decimal(2) / 3));
+    EXPECT_EQ("15241578750190521", text(Decimal(123456789) * Decimal(123456789)));
+    EXPECT_EQ("1.21", text(pow(Decimal::from_digits("11", -1), 2)));
+    EXPECT_EQ("0.01", text(pow(Decimal(10), -2)));
+    EXPECT_EQ("-1", text(remainder(Decimal(-13), 4)));
+    EXPECT_EQ("0.5", text(remainder(Decimal::from_digits("25", -1), 1)));
+    EXPECT_EQ("2", text(Decimal::from_digits("15", -19) * Decimal(0) + Decimal(2)));
+    EXPECT_EQ("0.000000000000000002", text(Decimal::from_digits("15", -19)));
+    EXPECT_TRUE((Decimal(1) / 0).is_nan());
+    EXPECT_TRUE(Decimal::from_digits("1", 21).is_nan());
+    EXPECT_TRUE((Decimal(100000) * Decimal(100000) * Decimal(100000) * Decimal(100000) * Decimal(100000)).is_nan());
+    EXPECT_FALSE(Decimal::nan() == Decimal::nan());
+    EXPECT_EQ("nan", text(Decimal::nan() + 1));
+    EXPECT_DOUBLE_EQ(1.5, static_cast<double>(Decimal(1.5L)));
+}
+
+TEST(Numbers, evaluate_line)
+{
+    bool rad_on = false;
+    ArgumentFormat format;
+    format.exponent = true;
+    EXPECT_EQ(0.1f, evaluate_line<float>(0, rad_on, "0.1").value);
+    EXPECT_EQ(1e-30f, evaluate_line<float>(0, rad_on, "1e-30", format).value);
+    EXPECT_EQ(0.1L, evaluate_line<long double>(0, rad_on, "0.1").value);
+    EXPECT_EQ(1234567890.123456789L, evaluate_line<long double>(0, rad_on, "1234567890.123456789", ArgumentFormat{0, false}).value);
+    EXPECT_EQ(0.5f, evaluate_line<float>(30, rad_on, "SIN").value);
+
+    auto result = evaluate_line<Decimal>(Decimal::from_digits("1", -1), rad_on, "+ 0.2");
+    EXPECT_EQ("0.3", text(result.value));
+    result = evaluate_line<Decimal>(result.value, rad_on, "* 1.5e2", format);
+    EXPECT_EQ("45", text(result.value));
+    result = evaluate_line<Decimal>(result.value, rad_on, "/ 0");
+    EXPECT_EQ("45", text(result.value));
+    EXPECT_EQ(Status::DivisionByZero, result.status);
+    result = evaluate_line<Decimal>(-4, rad_on, "SQRT");
+    EXPECT_EQ(Status::BadArgument, result.status);
+    EXPECT_EQ("2", text(evaluate_line<Decimal>(4, rad_on, "SQRT").value));
+    EXPECT_EQ("1", text(evaluate_line<Decimal>(90, rad_on, "SIN").value));
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "ImageIO.h"
+#include "SeamCarver.h"
+#include "SeamDP.h"
+
+/**
+ * Seam carving benchmark.
+ * For every image and orientation it times separately, averaged per seam:
+ *  energy    - energy of every pixel with SeamCarver::GetPixelEnergy
+ *  dp        - SeamDP relaxation of all lines over the precomputed energy
+ *  backtrack - picking the cheapest end and walking the direction plane
+ *  removal   - SeamCarver::Remove*Seam
+ *  find      - SeamCarver::Find*Seam as a whole
+ *  single    - find + remove with eager removal (compaction period 1)
+ *  batch     - find + remove of all seams with lazy removal (compaction period 0)
+ *  integer   - Find*Seam<IntegerEnergy>
+ *  approx    - Find*SeamApprox, its quality is the total energy of approximate seams
+ *              relative to the total energy of exact ones (1 is exact, more is worse)
+ * The seam of the split phases is checked against Find*Seam, the integer seam
+ * against the same DP in double over GetPixelSquaredEnergy, where all sums are exact.
+ * Once per run an integer seam is checked to take a long way through noise around a Protect line
+ * instead of crossing it, as a mask weight not scaled into squared units would let it.
+ * Results go to stdout and to a JSON file.
+ */
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Seam = std::vector<size_t>;
+
+double MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Options
+{
+    std::string output = "benchmark.json";
+    size_t maxSide = 7680;
+    size_t seams = 5;
+    std::vector<std::string> images;
+};
+
+struct Result
+{
+    std::string image;
+    size_t width = 0, height = 0;
+    bool vertical = true;
+    size_t seams = 0;
+    double energy = 0, dp = 0, backtrack = 0, removal = 0, find = 0, single = 0, batch = 0, integer = 0;
+    double approx = 0, approxQuality = 0;
+    bool verified = true, integerVerified = true;
+};
+
+/**
+ * Smooth gradients with noise, so that seams are neither straight nor random
+ */
+Image MakeSynthetic(size_t width, size_t height)
+{
+    std::mt19937 random(static_cast<std::mt19937::result_type>(width * 31 + height));
+    std::vector<std::vector<Image::Pixel>> table(width, std::vector<Image::Pixel>(height, Image::Pixel(0, 0, 0)));
+    for (size_t x = 0; x < width; ++x) {
+        for (size_t y = 0; y < height; ++y) {
+            const int noise = static_cast<int>(random() % 32);
+            table[x][y] = Image::Pixel(
+                    static_cast<int>(x * 223 / width) + noise,
+                    static_cast<int>(y * 223 / height) + noise,
+                    static_cast<int>((x + y) * 111 / (width + height)) + noise);
+        }
+    }
+    return Image(std::move(table));
+}
+
+/**
+ * Vertical IntegerEnergy seam on a flat left half and a noisy right half
+ * with the left three quarters of the middle row protected
+ * @return true if the seam doesn't go through the protected pixels
+ */
+bool CheckIntegerProtect()
+{
+    const size_t side = 64;
+    std::mt19937 random(side);
+    std::vector<std::vector<Image::Pixel>> table(side, std::vector<Image::Pixel>(side, Image::Pixel(128, 128, 128)));
+    for (size_t x = side / 2; x < side; ++x)
+        for (size_t y = 0; y < side; ++y)
+            table[x][y] = Image::Pixel(static_cast<int>(random() % 256), static_cast<int>(random() % 256),
+                    static_cast<int>(random() % 256));
+    SeamCarver carver{Image(std::move(table))};
+    SeamCarver::Mask mask(side, std::vector<int>(side, 0));
+    for (size_t x = 0; x < side * 3 / 4; ++x)
+        mask[x][side / 2] = SeamCarver::Protect;
+    carver.SetMask(mask);
+    return carver.FindVerticalSeam<SeamCarver::IntegerEnergy>()[side / 2] >= side * 3 / 4;
+}
+
+/**
+ * Same DP as SeamCarver::FindVerticalSeam / FindHorizontalSeam
+ * with backward energy, but run on an energy plane computed beforehand
+ */
+template <bool vertical>
+void RunDP(const std::vector<double> & plane, size_t lines, size_t length, SeamDP::Workspace & workspace)
+{
+    constexpr int step = vertical ? 1 : -1;
+    const size_t last = length - 1;
+    std::vector<double> &prev = workspace.real.prev, &cost = workspace.real.cost;
+    std::vector<SeamDP::Offset> & offsets = workspace.offsets;
+    prev.assign(plane.begin(), plane.begin() + static_cast<std::ptrdiff_t>(length));
+    cost.resize(length);
+    offsets.assign(length, 0);
+    workspace.directions.Reset(lines, length);
+    for (size_t line = 1; line < lines; ++line) {
+        const double * energy = &plane[line * length];
+        std::copy(energy, energy + length, cost.begin());
+        const size_t
+            firstEdge = vertical ? std::min<size_t>(1, last) : 0,
+            secondEdge = vertical ? 0 : std::min<size_t>(1, last);
+        SeamDP::RelaxEdge(cost[0], offsets[0], 0, prev[firstEdge], firstEdge, prev[secondEdge], secondEdge);
+        SeamDP::RelaxLine<step, false>(prev.data(), cost.data(), nullptr, nullptr, offsets.data(), length);
+        if (last >= 1)
+            SeamDP::RelaxEdge(cost[last], offsets[last], last, prev[last], last, prev[last - 1], last - 1);
+        workspace.directions.Store(line, offsets.data(), length);
+        prev.swap(cost);
+    }
+}
+
+Seam Backtrack(size_t lines, size_t length, const SeamDP::Workspace & workspace)
+{
+    double minSum = std::numeric_limits<double>::max();
+    size_t minInd = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (workspace.real.prev[i] < minSum) {
+            minSum = workspace.real.prev[i];
+            minInd = i;
+        }
+    }
+    Seam seam(lines);
+    seam[lines - 1] = minInd;
+    for (size_t line = lines - 1; line > 0; --line)
+        seam[line - 1] = static_cast<size_t>(static_cast<int>(seam[line]) + workspace.directions.Get(line, seam[line]));
+    return seam;
+}
+
+template <bool vertical>
+double SeamEnergy(const SeamCarver & carver, const Seam & seam)
+{
+    double energy = 0;
+    for (size_t line = 0; line < seam.size(); ++line)
+        energy += vertical ? carver.GetPixelEnergy(seam[line], line) : carver.GetPixelEnergy(line, seam[line]);
+    return energy;
+}
+
+template <bool vertical>
+Result Measure(const std::string & name, const Image & image, size_t seams)
+{
+    Result result;
+    result.image = name;
+    result.width = image.m_width;
+    result.height = image.m_height;
+    result.vertical = vertical;
+    const size_t available = (vertical ? image.m_width : image.m_height) - 1;
+    result.seams = seams = std::min(seams, available);
+    if (seams == 0)
+        return result;
+
+    {
+        SeamCarver carver(image);
+        SeamDP::Workspace workspace;
+        std::vector<double> plane;
+        double exactEnergy = 0, approxEnergy = 0;
+        for (size_t i = 0; i < seams; ++i) {
+            const size_t
+                lines = vertical ? carver.GetImageHeight() : carver.GetImageWidth(),
+                length = vertical ? carver.GetImageWidth() : carver.GetImageHeight();
+            plane.resize(lines * length);
+
+            Clock::time_point start = Clock::now();
+            // in the storage order of the image, column by column, as SeamCarver does
+            if (vertical) {
+                for (size_t j = 0; j < length; ++j)
+                    for (size_t line = 0; line < lines; ++line)
+                        plane[line * length + j] = carver.GetPixelEnergy(j, line);
+            } else {
+                for (size_t line = 0; line < lines; ++line)
+                    for (size_t j = 0; j < length; ++j)
+                        plane[line * length + j] = carver.GetPixelEnergy(line, j);
+            }
+            result.energy += MillisecondsSince(start);
+
+            start = Clock::now();
+            RunDP<vertical>(plane, lines, length, workspace);
+            result.dp += MillisecondsSince(start);
+
+            start = Clock::now();
+            const Seam seam = Backtrack(lines, length, workspace);
+            result.backtrack += MillisecondsSince(start);
+
+            start = Clock::now();
+            const Seam found = vertical ? carver.FindVerticalSeam() : carver.FindHorizontalSeam();
+            result.find += MillisecondsSince(start);
+            result.verified = result.verified && seam == found;
+
+            for (size_t line = 0; line < lines; ++line)
+                for (size_t j = 0; j < length; ++j)
+                    plane[line * length + j] = vertical ? carver.GetPixelSquaredEnergy(j, line)
+                            : carver.GetPixelSquaredEnergy(line, j);
+            RunDP<vertical>(plane, lines, length, workspace);
+            start = Clock::now();
+            const Seam integerSeam = vertical ? carver.FindVerticalSeam<SeamCarver::IntegerEnergy>()
+                    : carver.FindHorizontalSeam<SeamCarver::IntegerEnergy>();
+            result.integer += MillisecondsSince(start);
+            result.integerVerified = result.integerVerified && integerSeam == Backtrack(lines, length, workspace);
+
+            start = Clock::now();
+            const Seam approxSeam = vertical ? carver.FindVerticalSeamApprox() : carver.FindHorizontalSeamApprox();
+            result.approx += MillisecondsSince(start);
+            exactEnergy += SeamEnergy<vertical>(carver, seam);
+            approxEnergy += SeamEnergy<vertical>(carver, approxSeam);
+
+            start = Clock::now();
+            if (vertical)
+                carver.RemoveVerticalSeam(seam);
+            else
+                carver.RemoveHorizontalSeam(seam);
+            result.removal += MillisecondsSince(start);
+        }
+        result.approxQuality = exactEnergy > 0 ? approxEnergy / exactEnergy : 1;
+    }
+
+    for (const size_t period : {1, 0}) {
+        SeamCarver carver(image);
+        carver.SetCompactionPeriod(period);
+        const Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < seams; ++i) {
+            if (vertical)
+                carver.RemoveVerticalSeam(carver.FindVerticalSeam());
+            else
+                carver.RemoveHorizontalSeam(carver.FindHorizontalSeam());
+        }
+        carver.Compact();
+        (period == 1 ? result.single : result.batch) = MillisecondsSince(start);
+    }
+
+    for (double * time : {&result.energy, &result.dp, &result.backtrack, &result.removal,
+                &result.find, &result.single, &result.batch, &result.integer, &result.approx})
+        *time /= static_cast<double>(seams);
+    return result;
+}
+
+void Print(const Result & result)
+{
+    std::cout << result.image << " " << result.width << "x" << result.height
+              << (result.vertical ? " vertical" : " horizontal") << ", ms per seam:"
+              << " energy " << result.energy << ", dp " << result.dp << ", backtrack " << result.backtrack
+              << ", removal " << result.removal << ", find " << result.find
+              << ", single " << result.single << ", batch " << result.batch << ", integer " << result.integer
+              << ", approx " << result.approx << " (quality " << result.approxQuality << ")"
+              << (result.verified ? "" : " SEAM MISMATCH")
+              << (result.integerVerified ? "" : " INTEGER SEAM MISMATCH") << std::endl;
+}
+
+std::string Escape(const std::string & text)
+{
+    std::string escaped;
+    for (const char symbol : text) {
+        if (symbol == '"' || symbol == '\\')
+            escaped += '\\';
+        escaped += symbol;
+    }
+    return escaped;
+}
+
+bool WriteJSON(const std::string & filename, const Options & options, bool protectVerified,
+        const std::vector<Result> & results)
+{
+    std::ofstream file(filename);
+    file << "{\n  \"seams\": " << options.seams << ",\n  \"unit\": \"ms per seam\""
+         << ",\n  \"integer_protect_verified\": " << (protectVerified ? "true" : "false")
+         << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result & result = results[i];
+        file << (i == 0 ? "\n" : ",\n")
+             << "    {\"image\": \"" << Escape(result.image) << "\", \"width\": " << result.width
+             << ", \"height\": " << result.height
+             << ", \"orientation\": \"" << (result.vertical ? "vertical" : "horizontal") << "\""
+             << ", \"seams\": " << result.seams
+             << ", \"energy\": " << result.energy << ", \"dp\": " << result.dp
+             << ", \"backtrack\": " << result.backtrack << ", \"removal\": " << result.removal
+             << ", \"find\": " << result.find << ", \"single\": " << result.single
+             << ", \"batch\": " << result.batch << ", \"integer\": " << result.integer
+             << ", \"approx\": " << result.approx << ", \"approx_quality\": " << result.approxQuality
+             << ", \"verified\": " << (result.verified ? "true" : "false")
+             << ", \"integer_verified\": " << (result.integerVerified ? "true" : "false") << "}";
+    }
+    file << "\n  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool ParseOptions(int argc, char * argv[], Options & options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--json" || arg == "--max" || arg == "--seams") && i + 1 < argc) {
+            const char * value = argv[++i];
+            if (arg == "--json")
+                options.output = value;
+            else if (arg == "--max")
+                options.maxSide = std::strtoul(value, nullptr, 10);
+            else
+                options.seams = std::strtoul(value, nullptr, 10);
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.images.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char * argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        std::cout << "Usage: seam-carving-bench [--json out.json] [--max side] [--seams count] [image ...]\n";
+        std::cout << "Synthetic images from 256x256 up to 7680x4320 are limited by --max (longer side),\n";
+        std::cout << "images given by name (.csv, .ppm, .pnm, .pam) are measured too." << std::endl;
+        return 0;
+    }
+
+    const bool protectVerified = CheckIntegerProtect();
+    if (!protectVerified)
+        std::cout << "INTEGER SEAM CROSSED PROTECT MASK" << std::endl;
+
+    std::vector<Result> results;
+    const auto run = [&results, &options] (const std::string & name, const Image & image) {
+        results.push_back(Measure<true>(name, image, options.seams));
+        Print(results.back());
+        results.push_back(Measure<false>(name, image, options.seams));
+        Print(results.back());
+    };
+
+    const std::pair<size_t, size_t> sizes[] = {
+        {256, 256}, {512, 512}, {1024, 1024}, {1920, 1080}, {3840, 2160}, {7680, 4320}
+    };
+    for (const auto & [width, height] : sizes)
+        if (std::max(width, height) <= options.maxSide)
+            run("synthetic", MakeSynthetic(width, height));
+
+    for (const std::string & filename : options.images) {
+        ImageIO::Table table;
+        if (!ImageIO::Read(filename, ImageIO::GetFormat(filename), table)) {
+            std::cout << "Can't read " << filename << "." << std::endl;
+            continue;
+        }
+        run(filename, Image(std::move(table)));
+    }
+
+    if (WriteJSON(options.output, options, protectVerified, results))
+        std::cout << "Results are written to " << options.output << "." << std::endl;
+    else
+        std::cout << "Can't write results to " << options.output << "." << std::endl;
+    return 0;
+}
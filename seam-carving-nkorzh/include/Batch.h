@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Batch resizing: a manifest of jobs is processed by a fixed pool of worker threads,
+ * each worker keeps one SeamCarver so its DP buffers are reused from job to job
+ */
+namespace Batch
+{
+    struct Job
+    {
+        std::string input, output;
+        size_t width, height;   // target size, seams are removed or inserted to reach it
+    };
+
+    struct Result
+    {
+        bool done = false;
+        double seconds = 0;     // time spent on the job including reading and writing
+        size_t pixels = 0;      // pixels of the source image
+    };
+
+    struct Report
+    {
+        std::vector<Result> results;    // in order of jobs
+        size_t failed = 0;
+        double seconds = 0;             // wall time of the whole batch
+        double jobsPerSecond = 0, megapixelsPerSecond = 0;
+        double p50 = 0, p90 = 0, p99 = 0, max = 0;  // latency of done jobs in seconds
+    };
+
+    /**
+     * Reads manifest with a job per line: "input output width height".
+     * Blank lines and lines starting with '#' are skipped,
+     * sizes are positive integers up to 65536
+     * @return false if the file can't be read or a line is malformed
+     */
+    bool ReadManifest(const std::string & filename, std::vector<Job> & jobs);
+
+    /**
+     * Runs all jobs on `threads` workers (hardware concurrency if 0)
+     */
+    Report Run(const std::vector<Job> & jobs, size_t threads = 0);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 struct Image
@@ -11,6 +12,8 @@ struct Image
         int m_red{0};
         int m_green{0};
         int m_blue{0};
+        /// added to the pixel energy by SeamCarver, moves together with the pixel
+        int m_weight{0};
     };
 
     Image(std::vector<std::vector<Pixel>> table);
@@ -23,9 +26,29 @@ struct Image
     static double GetRedDif(const Pixel & a, const Pixel & b);
     static double GetGreenDif(const Pixel & a, const Pixel & b);
     static double GetBlueDif(const Pixel & a, const Pixel & b);
+    static Pixel GetAverage(const Pixel & a, const Pixel & b);
 
 
     void rewriteRowFrom(size_t columnId, size_t rowId);
     void rewriteColumnFrom(size_t columnId, size_t rowId);
-    std::vector<std::vector<Pixel>> m_table;
+
+    /**
+     * Lazy removal: every row keeps a gap of m_pendingColumns dead pixels
+     * starting at m_gapStart[row], so logical column x lives in the table
+     * at x or x + m_pendingColumns. Removing a pixel only moves the gap to it,
+     * which shifts as many pixels as the gap travels instead of the rest of the row.
+     * Call eraseFromRow for every row, then commitErasedColumn once.
+     */
+    void eraseFromRow(size_t columnId, size_t rowId);
+    void commitErasedColumn();
+
+    /**
+     * Closes all gaps in a single pass, m_table becomes m_width columns wide again.
+     * Logical pixels stay the same, so it is const and the storage is mutable
+     */
+    void compactRows() const;
+
+    mutable std::vector<std::vector<Pixel>> m_table;
+    mutable size_t m_pendingColumns = 0;
+    mutable std::vector<size_t> m_gapStart;
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Image.h"
+
+namespace ImageIO
+{
+    using Table = std::vector<std::vector<Image::Pixel>>;
+
+    enum class Format
+    {
+        Unknown,
+        CSV,    // text: "W H" header, then "R G B" per pixel, column by column
+        PPM,    // binary netpbm P6
+        PAM     // binary netpbm P7, depth 1 (gray) to 4 (RGB + alpha)
+    };
+
+    /**
+     * Guesses file format by its extension: .csv, .ppm/.pnm, .pam
+     */
+    Format GetFormat(const std::string & filename);
+
+    /**
+     * Parses header of a binary PPM (P6) held in memory
+     * @return false if it isn't one, otherwise image size, maximal sample value
+     * and offset of the raster from the beginning of data
+     */
+    bool ParsePPMHeader(const char * data, size_t size,
+            size_t & width, size_t & height, size_t & maxValue, size_t & rasterOffset);
+
+    /**
+     * Reads the whole file at once and decodes it into the pixel table,
+     * netpbm samples of any maximal value are scaled to 0..255
+     * @return false if the file can't be opened or is malformed
+     */
+    bool Read(const std::string & filename, Format format, Table & table);
+
+    /**
+     * Encodes image into a memory buffer and writes it with a single call
+     * @return false if the file can't be written
+     */
+    bool Write(const std::string & filename, Format format, const Image & image);
+}
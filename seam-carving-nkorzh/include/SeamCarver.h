@@ -1,16 +1,53 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
 #include "Image.h"
+#include "SeamDP.h"
 
 class SeamCarver
 {
     using Seam = std::vector<size_t>;
-    using SmartPixel = std::pair<double, size_t>;
 public:
+    /// pixel weights, column by column as in Image
+    using Mask = std::vector<std::vector<int>>;
+
+    /**
+     * Weights which dominate the GetPixelEnergy sum of seams up to ~1600 pixels long.
+     * IntegerEnergy scales weights by squaredWeightScale into squared units,
+     * see GetPixelSquaredEnergy
+     */
+    static constexpr int Protect = 1000000;
+    static constexpr int Remove = -1000000;
+
+    /// ratio of the maximal squared energy to the maximal energy, 6 * 255^2 / sqrt(6 * 255^2) rounded up
+    static constexpr std::int64_t squaredWeightScale = 625;
+
+    /**
+     * Seam cost policies, picked at compile time:
+     * BackwardEnergy sums GetPixelEnergy of the removed pixels,
+     * ForwardEnergy sums differences between pixels which become neighbours after removal,
+     * IntegerEnergy sums GetPixelSquaredEnergy in uint32 without a single floating point operation.
+     * Squared gradients weigh strong edges more than BackwardEnergy does, so its seams differ.
+     * Seam sums stick to UINT32_MAX instead of wrapping, which only happens
+     * for seams longer than ~11000 pixels of maximal energy or through Protect pixels
+     */
+    struct BackwardEnergy {};
+    struct ForwardEnergy {};
+    struct IntegerEnergy {};
+
     SeamCarver(Image image);
 
     /**
-     * Returns current image
+     * Starts over with another image,
+     * DP buffers grown for the previous ones are kept for reuse
+     */
+    void SetImage(Image image);
+
+    /**
+     * Compacts and returns current image
      */
     const Image& GetImage() const;
 
@@ -25,23 +62,58 @@ public:
     size_t GetImageHeight() const;
 
     /**
-     * Returns pixel energy
+     * Returns pixel energy plus its mask weight
      * @param columnId column index (x)
      * @param rowId row index (y)
      */
     double GetPixelEnergy(size_t columnId, size_t rowId) const;
 
+    /**
+     * Returns squared pixel energy (no sqrt) plus its mask weight times squaredWeightScale,
+     * clamped to [0, UINT32_MAX].
+     * Protect or more gives UINT32_MAX, so every seam through the pixel sums to the maximum
+     * and loses to any seam around it that doesn't saturate.
+     * Costs can't go below zero, so when the image has negative weights every pixel also gets
+     * an offset of the largest of them, only as much as keeps seams of maximal energy below
+     * UINT32_MAX. The offset is the same for all pixels and doesn't change which seam is the
+     * cheapest; Remove pixels cost 0 and win over the rest by the offset
+     */
+    std::uint32_t GetPixelSquaredEnergy(size_t columnId, size_t rowId) const;
+
+    /**
+     * Sets weights added to the energy of every pixel:
+     * positive ones keep seams away from a region, negative ones pull seams into it.
+     * Weights are stored in the pixels, so they follow the image through
+     * seam removal and insertion without any extra work
+     * @return false if mask size differs from the image size
+     */
+    bool SetMask(const Mask & mask);
+
     /**
      * Returns sequence of pixel row indexes (y)
      * (x indexes are [0:W-1])
      */
     Seam FindHorizontalSeam() const;
+    template <class Energy>
+    Seam FindHorizontalSeam() const;
 
     /**
      * Returns sequence of pixel column indexes (x)
      * (y indexes are [0:H-1])
      */
     Seam FindVerticalSeam() const;
+    template <class Energy>
+    Seam FindVerticalSeam() const;
+
+    /**
+     * Approximate seams for previews: the seam is found on the image downsampled
+     * `factor` times in both directions, then refined at full resolution
+     * within 3 * factor pixels around it.
+     * The downsampled image is kept and only rebuilt after `factor` seams
+     * of the same direction were removed, as one coarse seam stands for `factor` fine ones
+     */
+    Seam FindHorizontalSeamApprox(size_t factor = 4) const;
+    Seam FindVerticalSeamApprox(size_t factor = 4) const;
 
     /**
      * Removes sequence of pixels from the image
@@ -53,11 +125,83 @@ public:
      */
     void RemoveVerticalSeam(const Seam& seam);
 
+    /**
+     * Sets how vertical seams are removed:
+     * 1 (default) shifts the rest of every row right away,
+     * N > 1 only moves per-row gaps and compacts the image every N seams,
+     * 0 compacts only on Compact() or before a horizontal seam is removed
+     */
+    void SetCompactionPeriod(size_t seams);
+
+    /**
+     * Physically drops lazily removed pixels from the image,
+     * does nothing if there are none
+     */
+    void Compact() const;
+
+    /**
+     * Enlarges the image by `count` vertical seams:
+     * the lowest-energy seams are found in one pass over a carved copy,
+     * then each of them is followed by the average of it and its right neighbour.
+     * Up to GetImageWidth() - 1 seams are inserted per reallocation,
+     * an image one pixel wide has its column repeated
+     */
+    void InsertVerticalSeams(size_t count);
+
+    /**
+     * Enlarges the image by `count` horizontal seams,
+     * each of them is followed by the average of it and its lower neighbour,
+     * an image one pixel high has its row repeated
+     */
+    void InsertHorizontalSeams(size_t count);
+
 private:
     Image m_image;
+    size_t m_compactionPeriod = 1;
+    /// added to every GetPixelSquaredEnergy to make room for negative weights
+    std::int64_t m_squaredOffset = 0;
+    /// scratch of the seam search, reused by every Find*Seam call
+    mutable SeamDP::Workspace m_workspace;
+
+    /// downsampled image of the approximate search and the image size it was built for
+    struct Pyramid
+    {
+        std::unique_ptr<SeamCarver> level;
+        bool vertical = true;
+        size_t factor = 0, lines = 0, length = 0;
+    };
+    mutable Pyramid m_pyramid;
 
-    void getEnergy(std::vector<std::vector<SmartPixel>> &) const;
+    /**
+     * Picks m_squaredOffset for the weights and the size of the current image
+     */
+    void updateSquaredOffset();
+
+    /**
+     * Runs the DP line by line: rows for vertical seams, columns for horizontal ones
+     */
+    template <class Energy, bool vertical>
+    Seam findSeam() const;
+
+    /**
+     * Coarse search and banded refinement of the approximate seams
+     */
+    template <bool vertical>
+    Seam findSeamApprox(size_t factor) const;
+
+    /// type of DP costs of the energy policy
+    template <class Energy>
+    using CostOf = std::conditional_t<std::is_same_v<Energy, IntegerEnergy>, std::uint32_t, double>;
 
-    void setPixelAncestor(SmartPixel & Pixel, const SmartPixel & left, size_t leftInd,
-            const SmartPixel & mid, size_t midInd, const SmartPixel & right, size_t rightInd) const;
+    /// lines whose costs are computed at once
+    static constexpr size_t stripLines = 32;
+
+    /**
+     * Fills costs of `count` lines starting from firstLine into the workspace strip
+     * for the given policy, walking the image in its storage order.
+     * ForwardEnergy also fills extra cost of coming from the neighbour
+     * at position + step (toFirst) and position - step (toThird)
+     */
+    template <class Energy, bool vertical>
+    void stripCosts(size_t firstLine, size_t count) const;
 };
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Building blocks of the seam DP shared by the in-memory and streaming carvers.
+ * Ancestors are kept as offsets -1, 0, +1 from the current position.
+ */
+namespace SeamDP
+{
+    using Offset = std::int8_t;
+
+    /**
+     * Sum of two costs, integer sums stick to the maximum instead of wrapping
+     */
+    template <class Cost>
+    Cost Add(Cost a, Cost b)
+    {
+        if constexpr (std::is_floating_point_v<Cost>) {
+            return a + b;
+        } else {
+            static_assert(std::is_unsigned_v<Cost>, "integer costs must be unsigned");
+            const Cost sum = a + b;
+            return sum < a ? std::numeric_limits<Cost>::max() : sum;
+        }
+    }
+
+    /**
+     * Relaxes interior cells [1, length - 2] of a DP line:
+     * cost[i] += min(prev[i + step], prev[i], prev[i - step]),
+     * on ties the candidates are preferred in this order.
+     * With transitions toFirst[i] and toThird[i] are added to the side candidates.
+     * Offset of the chosen cell goes to offsets[i].
+     */
+    template <int step, bool transitions, class Cost>
+    void RelaxLine(const Cost * prev, Cost * cost,
+            const std::common_type_t<Cost> * toFirst, const std::common_type_t<Cost> * toThird,  // may be nullptr
+            Offset * offsets, size_t length)
+    {
+        /* no branches inside: min and select of both cost and offset
+         * are compiled into packed compare/blend instructions
+         */
+        const Cost
+            *first = prev + step,
+            *third = prev - step;
+        for (size_t i = 1; i + 1 < length; ++i) {
+            Cost firstCost = first[i], thirdCost = third[i];
+            if constexpr (transitions) {
+                firstCost = Add(firstCost, toFirst[i]);
+                thirdCost = Add(thirdCost, toThird[i]);
+            }
+            // selects between non-constant indexes blend well, offsets are derived afterwards
+            const Cost minCost = std::min(firstCost, prev[i]);
+            const std::uint32_t
+                index = static_cast<std::uint32_t>(i),
+                minInd = firstCost <= prev[i] ? index + step : index,
+                ancestor = thirdCost < minCost ? index - step : minInd;
+            offsets[i] = static_cast<Offset>(ancestor - index);
+            cost[i] = Add(cost[i], std::min(minCost, thirdCost));
+        }
+    }
+
+    /**
+     * Picks the cheaper of two candidates for cell i, the first one wins on ties
+     */
+    template <class Cost>
+    void RelaxEdge(Cost & cost, Offset & offset, size_t i,
+            Cost first, size_t firstInd, Cost second, size_t secondInd)
+    {
+        if (first <= second) {
+            cost = Add(cost, first);
+            offset = static_cast<Offset>(static_cast<int>(firstInd) - static_cast<int>(i));
+        } else {
+            cost = Add(cost, second);
+            offset = static_cast<Offset>(static_cast<int>(secondInd) - static_cast<int>(i));
+        }
+    }
+
+    /**
+     * Seam through bands [bandStart[line], bandStart[line] + bandLength) of a DP over lines of `length` cells,
+     * neighbouring bands must overlap. Cell costs come from energy(line, i),
+     * candidates are preferred in the order of RelaxLine
+     */
+    template <int step, class EnergyFunction>
+    std::vector<size_t> FindBandedSeam(const std::vector<size_t> & bandStart, size_t bandLength, size_t length,
+            EnergyFunction energy)
+    {
+        /// candidates out of the previous band or the image cost infinity
+        constexpr double infinity = std::numeric_limits<double>::infinity();
+        const size_t lines = bandStart.size(), last = length - 1;
+        std::vector<double> prev(bandLength), cost(bandLength);
+        std::vector<Offset> offsets(lines * bandLength, 0);
+        for (size_t j = 0; j < bandLength; ++j)
+            prev[j] = energy(0, bandStart[0] + j);
+        for (size_t line = 1; line < lines; ++line) {
+            const size_t start = bandStart[line], prevStart = bandStart[line - 1];
+            for (size_t j = 0; j < bandLength; ++j) {
+                const size_t i = start + j;
+                const auto candidate = [&] (int offset) {
+                    const size_t neighbour = i + static_cast<size_t>(offset);
+                    if ((offset < 0 && i == 0) || (offset > 0 && i == last)
+                            || neighbour < prevStart || neighbour >= prevStart + bandLength)
+                        return infinity;
+                    return prev[neighbour - prevStart];
+                };
+                const double first = candidate(step), second = candidate(0), third = candidate(-step);
+                double minCost = first <= second ? first : second;
+                Offset offset = first <= second ? step : 0;
+                if (third < minCost) {
+                    minCost = third;
+                    offset = -step;
+                }
+                offsets[line * bandLength + j] = offset;
+                cost[j] = minCost + energy(line, i);
+            }
+            prev.swap(cost);
+        }
+
+        size_t minInd = 0;
+        for (size_t j = 1; j < bandLength; ++j)
+            if (prev[j] < prev[minInd])
+                minInd = j;
+        std::vector<size_t> seam(lines);
+        seam[lines - 1] = bandStart[lines - 1] + minInd;
+        for (size_t line = lines - 1; line > 0; --line) {
+            const size_t j = seam[line] - bandStart[line];
+            seam[line - 1] = static_cast<size_t>(static_cast<int>(seam[line]) + offsets[line * bandLength + j]);
+        }
+        return seam;
+    }
+
+    /**
+     * Ancestor offsets of every DP cell packed into 2 bits, four cells per byte
+     */
+    class DirectionPlane
+    {
+    public:
+        /**
+         * Prepares plane of `lines` lines by `length` cells, keeps the memory if it is large enough
+         */
+        void Reset(size_t lines, size_t length)
+        {
+            m_stride = (length + 3) / 4;
+            m_codes.assign(lines * m_stride, 0);
+        }
+
+        /**
+         * Packs offsets of the whole line
+         */
+        void Store(size_t line, const Offset * offsets, size_t length)
+        {
+            std::uint8_t * codes = &m_codes[line * m_stride];
+            for (size_t i = 0; i < length; i += 4) {
+                std::uint8_t packed = 0;
+                for (size_t k = 0; k < 4 && i + k < length; ++k)
+                    packed |= static_cast<std::uint8_t>((offsets[i + k] + 1) << (2 * k));
+                codes[i / 4] = packed;
+            }
+        }
+
+        /**
+         * Returns offset of the ancestor of cell i
+         */
+        int Get(size_t line, size_t i) const
+        {
+            return (m_codes[line * m_stride + i / 4] >> (2 * (i % 4)) & 3) - 1;
+        }
+
+        /**
+         * Gets amount of memory held by the plane
+         */
+        size_t GetSize() const
+        {
+            return m_codes.capacity();
+        }
+
+    private:
+        size_t m_stride = 0;
+        std::vector<std::uint8_t> m_codes;
+    };
+
+    /**
+     * Cost buffers of one seam search: two cumulative cost rows
+     * and a strip of pixel costs with transition costs
+     */
+    template <class Cost>
+    struct CostLines
+    {
+        std::vector<Cost> prev, cost;
+        std::vector<Cost> energy, toFirst, toThird;
+
+        size_t GetSize() const
+        {
+            return (prev.capacity() + cost.capacity() + energy.capacity() + toFirst.capacity() + toThird.capacity())
+                    * sizeof(Cost);
+        }
+    };
+
+    /**
+     * Scratch buffers of seam searches: cost lines of floating point and integer costs,
+     * offsets of the current line and the direction plane.
+     * They only grow, so a workspace reused across searches and images stops allocating
+     */
+    struct Workspace
+    {
+        CostLines<double> real;
+        CostLines<std::uint32_t> integer;
+        std::vector<Offset> offsets;
+        DirectionPlane directions;
+
+        template <class Cost>
+        CostLines<Cost> & GetLines()
+        {
+            if constexpr (std::is_same_v<Cost, double>)
+                return real;
+            else
+                return integer;
+        }
+
+        /**
+         * Gets amount of memory held by the buffers
+         */
+        size_t GetSize() const
+        {
+            return real.GetSize() + integer.GetSize()
+                    + offsets.capacity() * sizeof(Offset) + directions.GetSize();
+        }
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Image.h"
+
+/**
+ * Removal order of vertical (or horizontal) seams: every pixel stores the iteration
+ * at which it was carved away (or Kept if it survived all of them).
+ * Built once, it gives an image of any width (height) between the original
+ * and the minimal one in a single pass without running the DP again.
+ */
+class SeamIndexMap
+{
+public:
+    using Index = std::uint32_t;
+    static constexpr Index Kept = UINT32_MAX;
+
+    enum class Orientation
+    {
+        Vertical,   // seams go top to bottom, the map narrows the image
+        Horizontal  // seams go left to right, the map lowers the image
+    };
+
+    SeamIndexMap() = default;
+
+    /**
+     * Carves `seams` seams of the given orientation from the image with SeamCarver
+     * and records the removal order of every pixel
+     */
+    SeamIndexMap(const Image & image, size_t seams, Orientation orientation = Orientation::Vertical);
+
+    /**
+     * Gets orientation of the recorded seams
+     */
+    Orientation GetOrientation() const;
+
+    /**
+     * Gets width and height of the image the map was built for
+     */
+    size_t GetWidth() const;
+    size_t GetHeight() const;
+
+    /**
+     * Gets the smallest width and height the map can produce
+     */
+    size_t GetMinWidth() const;
+    size_t GetMinHeight() const;
+
+    /**
+     * Gets amount of recorded seams
+     */
+    size_t GetSeamCount() const;
+
+    /**
+     * Returns iteration at which pixel (columnId, rowId) was removed
+     */
+    Index GetIndex(size_t columnId, size_t rowId) const;
+
+    /**
+     * Returns the original image narrowed to width in [GetMinWidth(), GetWidth()]
+     * or lowered to height in [GetMinHeight(), GetHeight()] for horizontal seams
+     */
+    Image Resize(const Image & image, size_t size) const;
+
+    /**
+     * Stores map in a binary file next to the image
+     * @return false if the file can't be written
+     */
+    bool Save(const std::string & filename) const;
+
+    /**
+     * Loads map previously stored with Save
+     * @return false if the file can't be read or is malformed
+     */
+    bool Load(const std::string & filename);
+
+private:
+    Orientation m_orientation = Orientation::Vertical;
+    size_t m_width = 0, m_height = 0, m_seams = 0;
+    /// removal iteration of every pixel, column by column as in Image
+    std::vector<Index> m_index;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "Image.h"
+#include "SeamCarver.h"
+
+/**
+ * Narrows every frame of a video by the same amount of vertical seams.
+ * Energy of a frame is carried over from the previous one and recomputed only
+ * around pixels which changed by more than a threshold; during carving it is
+ * updated only next to the removed seams. Each seam is searched within a window
+ * around the same seam of the previous frame, which keeps seams from jumping
+ * between frames (flicker) and makes the DP cost proportional to the window.
+ * The first frame and frames of another size are carved exactly.
+ */
+class SequenceCarver
+{
+    using Seam = std::vector<size_t>;
+public:
+    /**
+     * @param seams amount of seams removed from every frame
+     * @param threshold largest channel difference still treated as unchanged
+     * @param window how far a seam may move from its position in the previous frame
+     */
+    SequenceCarver(size_t seams, int threshold = 0, size_t window = 8);
+
+    /**
+     * Returns the frame narrowed by the given amount of seams
+     */
+    Image CarveFrame(Image frame);
+
+    /**
+     * Gets seams removed from the last frame, each in coordinates
+     * of the frame with the previous seams already removed
+     */
+    const std::vector<Seam> & GetSeams() const;
+
+    /**
+     * Gets amount of pixels whose energy was recomputed for the last frame
+     * before carving started
+     */
+    size_t GetRecomputedPixels() const;
+
+private:
+    size_t m_seams;
+    int m_threshold;
+    size_t m_window;
+
+    std::optional<SeamCarver> m_carver;
+    size_t m_width = 0, m_height = 0;
+    /// pixels the carried energy was computed from
+    std::vector<std::vector<Image::Pixel>> m_reference;
+    /// energy of the uncarved frame and of the frame being carved, row by row
+    std::vector<double> m_energy, m_carved;
+    std::vector<Seam> m_previous;
+    size_t m_recomputed = 0;
+
+    void carveExact();
+    void carveNearPrevious();
+    void removeSeam(const Seam & seam);
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "SeamDP.h"
+
+/**
+ * Out-of-core vertical seam carving of a binary 8 bit PPM file.
+ * The file is memory-mapped and carved in place; energy and the DP
+ * are computed in horizontal strips, so only the strip energies,
+ * two DP cost rows and a 2 bit per pixel direction plane stay resident.
+ * Produces the same seams as SeamCarver::FindVerticalSeam.
+ */
+class StreamingSeamCarver
+{
+    using Seam = std::vector<size_t>;
+public:
+    StreamingSeamCarver() = default;
+    StreamingSeamCarver(const StreamingSeamCarver &) = delete;
+    StreamingSeamCarver & operator=(const StreamingSeamCarver &) = delete;
+    ~StreamingSeamCarver();
+
+    /**
+     * Maps the file for reading and writing
+     * @return false if the file can't be mapped, isn't a binary 8 bit PPM
+     * or its header is too short to be rewritten in place
+     */
+    bool Open(const std::string & filename);
+
+    /**
+     * Writes the new header with the original maximal sample value,
+     * packs rows to the current width, unmaps the file and truncates it
+     * @return false if the header doesn't fit or the file can't be truncated
+     */
+    bool Close();
+
+    /**
+     * Sets amount of rows whose energy is computed at once
+     */
+    void SetStripHeight(size_t rows);
+
+    /**
+     * Gets current image width
+     */
+    size_t GetImageWidth() const;
+
+    /**
+     * Gets current image height
+     */
+    size_t GetImageHeight() const;
+
+    /**
+     * Returns pixel energy, same as SeamCarver::GetPixelEnergy
+     */
+    double GetPixelEnergy(size_t columnId, size_t rowId) const;
+
+    /**
+     * Returns sequence of pixel column indexes (x)
+     * (y indexes are [0:H-1])
+     */
+    Seam FindVerticalSeam();
+
+    /**
+     * Removes sequence of pixels from the mapped image
+     */
+    void RemoveVerticalSeam(const Seam & seam);
+
+    /**
+     * Gets amount of memory held by the DP buffers
+     */
+    size_t GetResidentSize() const;
+
+private:
+    int m_file = -1;
+    unsigned char * m_data = nullptr;
+    size_t m_fileSize = 0;
+    size_t m_headerSize = 0;
+    size_t m_width = 0, m_height = 0;
+    size_t m_maxValue = 0;
+    /// bytes between rows, stays the original row size until Close
+    size_t m_stride = 0;
+    size_t m_stripHeight = 64;
+
+    std::vector<double> m_strip, m_prev, m_cost;
+    std::vector<SeamDP::Offset> m_offsets;
+    SeamDP::DirectionPlane m_directions;
+
+    /// header for the current width, never longer than the parsed one
+    std::string header() const;
+    const unsigned char * pixel(size_t columnId, size_t rowId) const;
+};
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "Batch.h"
+#include "ImageIO.h"
+#include "SeamCarver.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// limits of a target size: per side, and relative to the source in Process
+constexpr size_t maxSide = 1 << 16;
+constexpr size_t maxScale = 4;
+
+double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Value at the given fraction of sorted values, nearest rank
+ */
+double Percentile(const std::vector<double> & sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/**
+ * Reads a target side: digits only, so "-5" doesn't wrap around, in [1, maxSide]
+ */
+bool ReadSide(std::istream & fields, size_t & side)
+{
+    std::string token;
+    if (!(fields >> token))
+        return false;
+    const char * end = token.data() + token.size();
+    auto [ptr, error] = std::from_chars(token.data(), end, side);
+    return error == std::errc() && ptr == end && side != 0 && side <= maxSide;
+}
+
+/**
+ * Reads the source, resizes it to the target size and writes the result.
+ * The carver is created by the first job of the worker and reused afterwards
+ * @return false if a file can't be read or written, the target is more than maxScale times
+ * the source in any direction or the target size isn't reached
+ */
+bool Process(const Batch::Job & job, std::optional<SeamCarver> & carver, size_t & pixels)
+{
+    const ImageIO::Format
+        inputFormat = ImageIO::GetFormat(job.input),
+        outputFormat = ImageIO::GetFormat(job.output);
+    ImageIO::Table table;
+    if (inputFormat == ImageIO::Format::Unknown || outputFormat == ImageIO::Format::Unknown
+            || !ImageIO::Read(job.input, inputFormat, table))
+        return false;
+    Image image(std::move(table));
+    if (carver) {
+        carver->SetImage(std::move(image));
+    } else {
+        carver.emplace(std::move(image));
+        // gaps are closed once before horizontal seams or writing
+        carver->SetCompactionPeriod(0);
+    }
+    pixels = carver->GetImageWidth() * carver->GetImageHeight();
+    if (job.width > carver->GetImageWidth() * maxScale || job.height > carver->GetImageHeight() * maxScale)
+        return false;
+
+    while (carver->GetImageWidth() > job.width)
+        carver->RemoveVerticalSeam(carver->FindVerticalSeam());
+    if (carver->GetImageWidth() < job.width)
+        carver->InsertVerticalSeams(job.width - carver->GetImageWidth());
+    while (carver->GetImageHeight() > job.height)
+        carver->RemoveHorizontalSeam(carver->FindHorizontalSeam());
+    if (carver->GetImageHeight() < job.height)
+        carver->InsertHorizontalSeams(job.height - carver->GetImageHeight());
+    if (carver->GetImageWidth() != job.width || carver->GetImageHeight() != job.height)
+        return false;
+    return ImageIO::Write(job.output, outputFormat, carver->GetImage());
+}
+
+} // anonymous namespace
+
+bool Batch::ReadManifest(const std::string & filename, std::vector<Job> & jobs)
+{
+    std::ifstream file(filename);
+    if (!file)
+        return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        Job job;
+        if (!(fields >> job.input) || job.input[0] == '#')
+            continue;
+        std::string rest;
+        if (!(fields >> job.output) || !ReadSide(fields, job.width) || !ReadSide(fields, job.height)
+                || fields >> rest)
+            return false;
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+Batch::Report Batch::Run(const std::vector<Job> & jobs, size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<size_t>(jobs.size(), 1));
+
+    Report report;
+    report.results.resize(jobs.size());
+    std::atomic<size_t> next{0};
+    const auto worker = [&jobs, &report, &next] {
+        std::optional<SeamCarver> carver;
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            Result & result = report.results[i];
+            const Clock::time_point start = Clock::now();
+            result.done = Process(jobs[i], carver, result.pixels);
+            result.seconds = SecondsSince(start);
+        }
+    };
+
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < threads; ++i)
+        pool.emplace_back(worker);
+    for (std::thread & thread : pool)
+        thread.join();
+    report.seconds = SecondsSince(start);
+
+    std::vector<double> latencies;
+    size_t pixels = 0;
+    for (const Result & result : report.results) {
+        if (!result.done) {
+            ++report.failed;
+            continue;
+        }
+        latencies.push_back(result.seconds);
+        pixels += result.pixels;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    if (report.seconds > 0) {
+        report.jobsPerSecond = static_cast<double>(latencies.size()) / report.seconds;
+        report.megapixelsPerSecond = static_cast<double>(pixels) / 1e6 / report.seconds;
+    }
+    report.p50 = Percentile(latencies, 0.5);
+    report.p90 = Percentile(latencies, 0.9);
+    report.p99 = Percentile(latencies, 0.99);
+    report.max = latencies.empty() ? 0 : latencies.back();
+    return report;
+}
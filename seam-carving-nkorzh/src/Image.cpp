@@ -12,6 +12,8 @@ Image::Pixel::Pixel(int red, int green, int blue)
 
 const Image::Pixel & Image::GetPixel(size_t columnId, size_t rowId) const
 {
+    if (m_pendingColumns != 0 && columnId >= m_gapStart[rowId])
+        columnId += m_pendingColumns;
     return m_table[columnId][rowId];
 }
 
@@ -47,6 +49,12 @@ double Image::GetBlueDif( const Image::Pixel &a, const Image::Pixel &b ) {
     return static_cast<double>(a.m_blue - b.m_blue);
 }
 
+Image::Pixel Image::GetAverage( const Image::Pixel &a, const Image::Pixel &b ) {
+    Pixel average((a.m_red + b.m_red) / 2, (a.m_green + b.m_green) / 2, (a.m_blue + b.m_blue) / 2);
+    average.m_weight = a.m_weight / 2 + b.m_weight / 2;
+    return average;
+}
+
 void Image::rewriteRowFrom( size_t columnId, size_t rowId ) {
     for (size_t x = columnId; x < m_width - 1; ++x) {
         m_table[x][rowId] = m_table[x + 1][rowId];
@@ -58,3 +66,41 @@ void Image::rewriteColumnFrom( size_t columnId, size_t rowId ) {
         m_table[columnId][y] = m_table[columnId][y + 1];
     }
 }
+
+void Image::eraseFromRow( size_t columnId, size_t rowId ) {
+    if (m_pendingColumns == 0) {
+        m_gapStart.resize(m_height);
+        m_gapStart[rowId] = columnId;
+        return;
+    }
+    size_t & gapStart = m_gapStart[rowId];
+    if (columnId < gapStart) {
+        // pixels (columnId, gapStart) jump over the gap to its right side
+        for (size_t x = gapStart; x-- > columnId + 1; )
+            m_table[x + m_pendingColumns][rowId] = m_table[x][rowId];
+    } else {
+        // pixels [gapStart, columnId) jump over the gap to its left side
+        for (size_t x = gapStart; x < columnId; ++x)
+            m_table[x][rowId] = m_table[x + m_pendingColumns][rowId];
+    }
+    gapStart = columnId;
+}
+
+void Image::commitErasedColumn() {
+    ++m_pendingColumns;
+    --m_width;
+}
+
+void Image::compactRows() const {
+    if (m_pendingColumns == 0)
+        return;
+    // column by column: reads and writes go along contiguous columns
+    for (size_t x = 0; x < m_width; ++x) {
+        for (size_t y = 0; y < m_height; ++y) {
+            if (x >= m_gapStart[y])
+                m_table[x][y] = m_table[x + m_pendingColumns][y];
+        }
+    }
+    m_table.resize(m_width);
+    m_pendingColumns = 0;
+}
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+
+#include "ImageIO.h"
+
+namespace {
+
+/**
+ * Forward-only cursor over a file loaded into memory
+ */
+struct Cursor
+{
+    const char * m_pos;
+    const char * m_end;
+
+    void skipSpaces()
+    {
+        while (m_pos < m_end && (std::isspace(static_cast<unsigned char>(*m_pos)) || *m_pos == '#')) {
+            if (*m_pos == '#') // netpbm comment lasts till the end of line
+                while (m_pos < m_end && *m_pos != '\n')
+                    ++m_pos;
+            else
+                ++m_pos;
+        }
+    }
+
+    bool readNumber(size_t & value)
+    {
+        skipSpaces();
+        auto [ptr, error] = std::from_chars(m_pos, m_end, value);
+        m_pos = ptr;
+        return error == std::errc();
+    }
+
+    bool readWord(std::string & word)
+    {
+        skipSpaces();
+        const char * begin = m_pos;
+        while (m_pos < m_end && !std::isspace(static_cast<unsigned char>(*m_pos)))
+            ++m_pos;
+        word.assign(begin, m_pos);
+        return !word.empty();
+    }
+
+    size_t left() const
+    {
+        return static_cast<size_t>(m_end - m_pos);
+    }
+};
+
+bool ReadFile(const std::string & filename, std::string & buffer)
+{
+    std::ifstream input(filename, std::ios::binary);
+    if (!input.good())
+        return false;
+    input.seekg(0, std::ios::end);
+    const std::streamoff size = input.tellg();
+    if (size < 0) // unseekable input
+        return false;
+    buffer.resize(static_cast<size_t>(size));
+    input.seekg(0, std::ios::beg);
+    input.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    return static_cast<size_t>(input.gcount()) == buffer.size();
+}
+
+bool WriteFile(const std::string & filename, const std::string & buffer)
+{
+    std::ofstream output(filename, std::ios::binary);
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    // data still in the stream buffer is only written by close, which can fail too
+    output.close();
+    return !output.fail();
+}
+
+void AllocateTable(ImageIO::Table & table, size_t width, size_t height)
+{
+    table.assign(width, std::vector<Image::Pixel>(height, Image::Pixel(0, 0, 0)));
+}
+
+bool ParseCSV(Cursor cursor, ImageIO::Table & table)
+{
+    size_t width, height;
+    if (!cursor.readNumber(width) || !cursor.readNumber(height) || width == 0 || height == 0)
+        return false;
+    AllocateTable(table, width, height);
+    for (auto & column : table) {
+        for (auto & pixel : column) {
+            size_t red, green, blue;
+            if (!cursor.readNumber(red) || !cursor.readNumber(green) || !cursor.readNumber(blue))
+                return false;
+            pixel = Image::Pixel(static_cast<int>(red), static_cast<int>(green), static_cast<int>(blue));
+        }
+    }
+    return true;
+}
+
+/**
+ * Decodes raster of interleaved samples, rows go top to bottom
+ * depth 1, 2: gray (+ alpha), depth 3, 4: RGB (+ alpha), alpha is dropped,
+ * samples are scaled from 0..maxValue to 0..255
+ */
+bool ParseRaster(Cursor cursor, ImageIO::Table & table, size_t width, size_t height, size_t depth, size_t maxValue)
+{
+    if (width == 0 || height == 0 || depth == 0 || depth > 4 || maxValue == 0 || maxValue > 65535)
+        return false;
+    const size_t sampleSize = maxValue < 256 ? 1 : 2;
+    // divides instead of multiplying, so a forged size can't wrap around
+    if (width > cursor.left() / sampleSize / depth / height)
+        return false;
+
+    const auto * data = reinterpret_cast<const unsigned char *>(cursor.m_pos);
+    // the writers always use 255, so samples are rescaled to it, rounding to the nearest;
+    // values above maxValue are malformed and saturate
+    std::vector<int> levels(sampleSize == 1 ? 256 : 65536);
+    for (size_t value = 0; value < levels.size(); ++value)
+        levels[value] = static_cast<int>((std::min(value, maxValue) * 255 + maxValue / 2) / maxValue);
+    const auto sample = [&data, &levels, sampleSize] (size_t index) {
+        return sampleSize == 1
+                ? levels[data[index]]
+                : levels[data[2 * index] << 8 | data[2 * index + 1]]; // big endian
+    };
+    AllocateTable(table, width, height);
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            const size_t base = (y * width + x) * depth;
+            table[x][y] = depth < 3
+                    ? Image::Pixel(sample(base), sample(base), sample(base))
+                    : Image::Pixel(sample(base), sample(base + 1), sample(base + 2));
+        }
+    }
+    return true;
+}
+
+bool ParsePPM(Cursor cursor, ImageIO::Table & table)
+{
+    size_t width, height, maxValue, rasterOffset;
+    if (!ImageIO::ParsePPMHeader(cursor.m_pos, cursor.left(), width, height, maxValue, rasterOffset))
+        return false;
+    cursor.m_pos += rasterOffset;
+    return ParseRaster(cursor, table, width, height, 3, maxValue);
+}
+
+bool ParsePAM(Cursor cursor, ImageIO::Table & table)
+{
+    std::string word;
+    if (!cursor.readWord(word) || word != "P7")
+        return false;
+    size_t width = 0, height = 0, depth = 0, maxValue = 0;
+    while (cursor.readWord(word) && word != "ENDHDR") {
+        if (word == "WIDTH")
+            cursor.readNumber(width);
+        else if (word == "HEIGHT")
+            cursor.readNumber(height);
+        else if (word == "DEPTH")
+            cursor.readNumber(depth);
+        else if (word == "MAXVAL")
+            cursor.readNumber(maxValue);
+        else if (word == "TUPLTYPE")
+            cursor.readWord(word);
+        else
+            return false;
+    }
+    if (word != "ENDHDR" || cursor.left() == 0)
+        return false;
+    ++cursor.m_pos; // newline after ENDHDR
+    return ParseRaster(cursor, table, width, height, depth, maxValue);
+}
+
+void AppendNumber(std::string & buffer, size_t value)
+{
+    char digits[20];
+    auto [end, error] = std::to_chars(std::begin(digits), std::end(digits), value);
+    (void)error;
+    buffer.append(digits, end);
+}
+
+void EncodeCSV(const Image & image, std::string & buffer)
+{
+    // at most "255 255 255\n" per pixel
+    buffer.reserve(buffer.size() + image.m_width * image.m_height * 12 + 32);
+    AppendNumber(buffer, image.m_width);
+    buffer += ' ';
+    AppendNumber(buffer, image.m_height);
+    buffer += '\n';
+    for (size_t columnId = 0; columnId < image.m_width; ++columnId) {
+        for (size_t rowId = 0; rowId < image.m_height; ++rowId) {
+            const Image::Pixel & pixel = image.GetPixel(columnId, rowId);
+            AppendNumber(buffer, static_cast<size_t>(pixel.m_red));
+            buffer += ' ';
+            AppendNumber(buffer, static_cast<size_t>(pixel.m_green));
+            buffer += ' ';
+            AppendNumber(buffer, static_cast<size_t>(pixel.m_blue));
+            buffer += '\n';
+        }
+    }
+}
+
+void EncodeRaster(const Image & image, std::string & buffer)
+{
+    const auto clamp = [] (int value) {
+        return static_cast<char>(std::clamp(value, 0, 255));
+    };
+    size_t pos = buffer.size();
+    buffer.resize(pos + image.m_width * image.m_height * 3);
+    for (size_t rowId = 0; rowId < image.m_height; ++rowId) {
+        for (size_t columnId = 0; columnId < image.m_width; ++columnId) {
+            const Image::Pixel & pixel = image.GetPixel(columnId, rowId);
+            buffer[pos++] = clamp(pixel.m_red);
+            buffer[pos++] = clamp(pixel.m_green);
+            buffer[pos++] = clamp(pixel.m_blue);
+        }
+    }
+}
+
+} // anonymous namespace
+
+ImageIO::Format ImageIO::GetFormat(const std::string & filename)
+{
+    const size_t dot = filename.rfind('.');
+    if (dot == std::string::npos)
+        return Format::Unknown;
+    std::string extension = filename.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+            [] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "csv")
+        return Format::CSV;
+    if (extension == "ppm" || extension == "pnm")
+        return Format::PPM;
+    if (extension == "pam")
+        return Format::PAM;
+    return Format::Unknown;
+}
+
+bool ImageIO::ParsePPMHeader(const char * data, size_t size,
+        size_t & width, size_t & height, size_t & maxValue, size_t & rasterOffset)
+{
+    Cursor cursor{data, data + size};
+    std::string magic;
+    if (!cursor.readWord(magic) || magic != "P6"
+            || !cursor.readNumber(width) || !cursor.readNumber(height) || !cursor.readNumber(maxValue)
+            || cursor.left() == 0)
+        return false;
+    ++cursor.m_pos; // single whitespace separates header from raster
+    rasterOffset = static_cast<size_t>(cursor.m_pos - data);
+    return true;
+}
+
+bool ImageIO::Read(const std::string & filename, Format format, Table & table)
+{
+    std::string buffer;
+    if (!ReadFile(filename, buffer))
+        return false;
+    Cursor cursor{buffer.data(), buffer.data() + buffer.size()};
+    switch (format) {
+        case Format::CSV:
+            return ParseCSV(cursor, table);
+        case Format::PPM:
+            return ParsePPM(cursor, table);
+        case Format::PAM:
+            return ParsePAM(cursor, table);
+        default:
+            return false;
+    }
+}
+
+bool ImageIO::Write(const std::string & filename, Format format, const Image & image)
+{
+    std::string buffer;
+    switch (format) {
+        case Format::CSV:
+            EncodeCSV(image, buffer);
+            break;
+        case Format::PPM:
+            buffer = "P6\n";
+            AppendNumber(buffer, image.m_width);
+            buffer += ' ';
+            AppendNumber(buffer, image.m_height);
+            buffer += "\n255\n";
+            EncodeRaster(image, buffer);
+            break;
+        case Format::PAM:
+            buffer = "P7\nWIDTH ";
+            AppendNumber(buffer, image.m_width);
+            buffer += "\nHEIGHT ";
+            AppendNumber(buffer, image.m_height);
+            buffer += "\nDEPTH 3\nMAXVAL 255\nTUPLTYPE RGB\nENDHDR\n";
+            EncodeRaster(image, buffer);
+            break;
+        default:
+            return false;
+    }
+    return WriteFile(filename, buffer);
+}
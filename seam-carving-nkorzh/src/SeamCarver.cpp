@@ -1,14 +1,31 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 #include "SeamCarver.h"
+#include "SeamIndexMap.h"
 
 
 SeamCarver::SeamCarver(Image image)
     : m_image(std::move(image))
-{}
+{
+    // a copy of another carver's image may still hold its gaps
+    Compact();
+    updateSquaredOffset();
+}
+
+void SeamCarver::SetImage(Image image)
+{
+    m_image = std::move(image);
+    Compact();
+    updateSquaredOffset();
+    m_pyramid.level.reset();
+}
 
 const Image& SeamCarver::GetImage() const
 {
+    Compact();
     return m_image;
 }
 
@@ -45,98 +62,303 @@ double SeamCarver::GetPixelEnergy(size_t columnId, size_t rowId) const
      * in the lowest/rightest cell this value is 255^2 * 3 * 2 * m_height or m_width
      * which is 3 901 500 000 < MAX_DOUBLE for longest side of 80 MP photo
      */
-    return sqrt(deltaX + deltaY);
+    return sqrt(deltaX + deltaY) + m_image.GetPixel(columnId, rowId).m_weight;
+}
+
+std::uint32_t SeamCarver::GetPixelSquaredEnergy(size_t columnId, size_t rowId) const
+{
+    auto SQR = [] (int value) { return static_cast<std::int64_t>(value) * value; };
+    const Image::Pixel &
+        Left = m_image.GetLeftPixel(columnId, rowId),
+        Right = m_image.GetRightPixel(columnId, rowId),
+        Top = m_image.GetTopPixel(columnId, rowId),
+        Bottom = m_image.GetBottomPixel(columnId, rowId);
+    const int weight = m_image.GetPixel(columnId, rowId).m_weight;
+    if (weight >= Protect)
+        return UINT32_MAX;
+    const std::int64_t energy =
+        SQR(Right.m_red - Left.m_red) + SQR(Right.m_green - Left.m_green) + SQR(Right.m_blue - Left.m_blue)
+        + SQR(Bottom.m_red - Top.m_red) + SQR(Bottom.m_green - Top.m_green) + SQR(Bottom.m_blue - Top.m_blue)
+        + weight * squaredWeightScale + m_squaredOffset;
+    return static_cast<std::uint32_t>(std::clamp<std::int64_t>(energy, 0, UINT32_MAX));
+}
+
+bool SeamCarver::SetMask(const Mask & mask)
+{
+    if (mask.size() != GetImageWidth())
+        return false;
+    for (const auto & column : mask)
+        if (column.size() != GetImageHeight())
+            return false;
+    Compact();
+    for (size_t x = 0; x < GetImageWidth(); ++x)
+        for (size_t y = 0; y < GetImageHeight(); ++y)
+            m_image.m_table[x][y].m_weight = mask[x][y];
+    updateSquaredOffset();
+    m_pyramid.level.reset();
+    return true;
+}
+
+void SeamCarver::updateSquaredOffset()
+{
+    int lowest = 0;
+    for (const auto & column : m_image.m_table)
+        for (const Image::Pixel & pixel : column)
+            lowest = std::min(lowest, pixel.m_weight);
+    /// seams of maximal energy must still fit, the longest one runs along the longer side
+    const std::int64_t
+        maxSquared = 6 * 255 * 255,
+        longest = static_cast<std::int64_t>(std::max<size_t>({GetImageWidth(), GetImageHeight(), 1})),
+        room = std::max<std::int64_t>(UINT32_MAX / longest - maxSquared, 0);
+    m_squaredOffset = std::min(-static_cast<std::int64_t>(lowest) * squaredWeightScale, room);
 }
 
 SeamCarver::Seam SeamCarver::FindHorizontalSeam() const
 {
-    /// start from the left, going right
-    std::vector<std::vector<SmartPixel>> energy;
-    getEnergy(energy);
-
-    size_t
-            rightest = GetImageWidth() - 1,
-            lowest = GetImageHeight() - 1;
-
-    for (size_t y = 0; y <= lowest; y++)
-        energy[0][y].second = y;
-
-    for (size_t column = 1; column <= rightest; ++column) {
-        setPixelAncestor(energy[column][0], energy[column - 1][0], 0,
-                         energy[column - 1][1], 1,
-                         energy[column - 1][1], 1);
-
-        for (size_t y = 1; y < lowest; y++)
-            setPixelAncestor(energy[column][y], energy[column - 1][y - 1], y - 1,
-                             energy[column - 1][y], y,
-                             energy[column - 1][y + 1], y + 1);
-        if (lowest >= 1)
-            setPixelAncestor(energy[column][lowest], energy[column - 1][lowest], lowest,
-                    energy[column - 1][lowest - 1], lowest - 1,
-                    energy[column - 1][lowest - 1], lowest - 1);
+    return findSeam<BackwardEnergy, false>();
+}
+
+template <class Energy>
+SeamCarver::Seam SeamCarver::FindHorizontalSeam() const
+{
+    return findSeam<Energy, false>();
+}
+
+SeamCarver::Seam SeamCarver::FindVerticalSeam() const
+{
+    return findSeam<BackwardEnergy, true>();
+}
+
+template <class Energy>
+SeamCarver::Seam SeamCarver::FindVerticalSeam() const
+{
+    return findSeam<Energy, true>();
+}
+
+template SeamCarver::Seam SeamCarver::FindHorizontalSeam<SeamCarver::BackwardEnergy>() const;
+template SeamCarver::Seam SeamCarver::FindHorizontalSeam<SeamCarver::ForwardEnergy>() const;
+template SeamCarver::Seam SeamCarver::FindVerticalSeam<SeamCarver::BackwardEnergy>() const;
+template SeamCarver::Seam SeamCarver::FindVerticalSeam<SeamCarver::ForwardEnergy>() const;
+template SeamCarver::Seam SeamCarver::FindHorizontalSeam<SeamCarver::IntegerEnergy>() const;
+template SeamCarver::Seam SeamCarver::FindVerticalSeam<SeamCarver::IntegerEnergy>() const;
+
+template <class Energy, bool vertical>
+SeamCarver::Seam SeamCarver::findSeam() const
+{
+    /// vertical: start from top, going down; horizontal: start from the left, going right
+    constexpr int step = vertical ? 1 : -1;
+    constexpr bool transitions = std::is_same_v<Energy, ForwardEnergy>;
+    using Cost = CostOf<Energy>;
+    const size_t
+        lines = vertical ? GetImageHeight() : GetImageWidth(),
+        length = vertical ? GetImageWidth() : GetImageHeight(),
+        last = length - 1;
+
+    /// cumulative cost of the previous and the current line, 2 bit ancestor directions of every pixel
+    SeamDP::CostLines<Cost> & buffers = m_workspace.GetLines<Cost>();
+    std::vector<Cost> &prev = buffers.prev, &cost = buffers.cost;
+    std::vector<SeamDP::Offset> & offsets = m_workspace.offsets;
+    SeamDP::DirectionPlane & directions = m_workspace.directions;
+    prev.resize(length);
+    cost.resize(length);
+    offsets.assign(length, 0);
+    directions.Reset(lines, length);
+    /// costs of the next stripLines lines, filled in the storage order of the image
+    const size_t strip = std::min(stripLines, lines);
+    buffers.energy.resize(strip * length);
+    buffers.toFirst.resize(transitions ? strip * length : 0);
+    buffers.toThird.resize(transitions ? strip * length : 0);
+
+    size_t stripStart = 0;
+    const auto lineCost = [this, &stripStart, length, lines] (size_t line, size_t offset) {
+        if (line == stripStart + stripLines || line == 0) {
+            stripStart = line;
+            stripCosts<Energy, vertical>(line, std::min(stripLines, lines - line));
+        }
+        return (line - stripStart) * length + offset;
+    };
+
+    std::copy_n(&buffers.energy[lineCost(0, 0)], length, prev.begin());
+    for (size_t line = 1; line < lines; ++line) {
+        const size_t first = lineCost(line, 0);
+        std::copy_n(&buffers.energy[first], length, cost.begin());
+        const Cost
+            *toFirst = transitions ? &buffers.toFirst[first] : nullptr,
+            *toThird = transitions ? &buffers.toThird[first] : nullptr;
+        /// extra cost of coming to cell i from cell j
+        const auto transition = [toFirst, toThird] (size_t i, size_t j) {
+            if constexpr (transitions)
+                return j == i + step ? toFirst[i] : (j == i - step ? toThird[i] : Cost{});
+            else
+                return Cost{};
+        };
+
+        const size_t
+            firstEdge = vertical ? std::min<size_t>(1, last) : 0,
+            secondEdge = vertical ? 0 : std::min<size_t>(1, last);
+        SeamDP::RelaxEdge(cost[0], offsets[0], 0,
+                SeamDP::Add(prev[firstEdge], transition(0, firstEdge)), firstEdge,
+                SeamDP::Add(prev[secondEdge], transition(0, secondEdge)), secondEdge);
+        SeamDP::RelaxLine<step, transitions>(prev.data(), cost.data(), toFirst, toThird,
+                offsets.data(), length);
+        if (last >= 1)
+            SeamDP::RelaxEdge(cost[last], offsets[last], last,
+                    SeamDP::Add(prev[last], transition(last, last)), last,
+                    SeamDP::Add(prev[last - 1], transition(last, last - 1)), last - 1);
+        directions.Store(line, offsets.data(), length);
+        prev.swap(cost);
     }
 
-    double minSum = 400000.0;
+    Cost minSum = std::numeric_limits<Cost>::max();
     size_t minInd = 0;
-    for (size_t y = 0; y <= lowest; ++y) {
-        if (energy[rightest][y].first < minSum) {
-            minSum = energy[rightest][y].first;
-            minInd = y;
+    for (size_t i = 0; i <= last; ++i) {
+        if (prev[i] < minSum) {
+            minSum = prev[i];
+            minInd = i;
         }
     }
-    Seam seam(GetImageWidth());
-    seam[rightest] = minInd;
-    for (size_t x = rightest; x > 0 ; --x) {
-        seam[x - 1] = energy[x][seam[x]].second;
+    Seam seam(lines);
+    seam[lines - 1] = minInd;
+    for (size_t line = lines - 1; line > 0 ; --line) {
+        seam[line - 1] = static_cast<size_t>(static_cast<int>(seam[line]) + directions.Get(line, seam[line]));
     }
     return seam;
 }
 
-SeamCarver::Seam SeamCarver::FindVerticalSeam() const
+SeamCarver::Seam SeamCarver::FindHorizontalSeamApprox(size_t factor) const
 {
-    /// start from top, going down
-    std::vector<std::vector<SmartPixel>> energy;
-    getEnergy(energy);
+    return findSeamApprox<false>(factor);
+}
 
-    size_t
-        rightest = GetImageWidth() - 1,
-        lowest = GetImageHeight() - 1;
+SeamCarver::Seam SeamCarver::FindVerticalSeamApprox(size_t factor) const
+{
+    return findSeamApprox<true>(factor);
+}
 
-    for (size_t x = 0; x <= rightest; x++)
-        energy[x][0].second = x;
+template <bool vertical>
+SeamCarver::Seam SeamCarver::findSeamApprox(size_t factor) const
+{
+    factor = std::max<size_t>(factor, 1);
+    const size_t
+        lines = vertical ? GetImageHeight() : GetImageWidth(),
+        length = vertical ? GetImageWidth() : GetImageHeight();
+    /// every pixel of the level is the average of a factor x factor block, mask weights included
+    Pyramid & pyramid = m_pyramid;
+    if (!pyramid.level || pyramid.vertical != vertical || pyramid.factor != factor || pyramid.lines != lines
+            || pyramid.length < length || pyramid.length - length >= factor) {
+        const size_t
+            width = (GetImageWidth() + factor - 1) / factor,
+            height = (GetImageHeight() + factor - 1) / factor;
+        std::vector<std::vector<Image::Pixel>> table(width, std::vector<Image::Pixel>(height, Image::Pixel(0, 0, 0)));
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t y = 0; y < height; ++y) {
+                long long red = 0, green = 0, blue = 0, weight = 0, count = 0;
+                for (size_t column = x * factor; column < std::min((x + 1) * factor, GetImageWidth()); ++column) {
+                    for (size_t row = y * factor; row < std::min((y + 1) * factor, GetImageHeight()); ++row) {
+                        const Image::Pixel & source = m_image.GetPixel(column, row);
+                        red += source.m_red;
+                        green += source.m_green;
+                        blue += source.m_blue;
+                        weight += source.m_weight;
+                        ++count;
+                    }
+                }
+                Image::Pixel & target = table[x][y];
+                target = Image::Pixel(static_cast<int>(red / count), static_cast<int>(green / count),
+                        static_cast<int>(blue / count));
+                target.m_weight = static_cast<int>(weight / count);
+            }
+        }
+        pyramid.level = std::make_unique<SeamCarver>(Image(std::move(table)));
+        pyramid.vertical = vertical;
+        pyramid.factor = factor;
+        pyramid.lines = lines;
+        pyramid.length = length;
+    }
+    const Seam coarse = vertical ? pyramid.level->FindVerticalSeam() : pyramid.level->FindHorizontalSeam();
 
-    for (size_t row = 1; row <= lowest; ++row) {
-        setPixelAncestor(energy[0][row], energy[1][row - 1], 1,
-                energy[1][row - 1], 1, energy[0][row - 1], 0);
+    /* band of every line: the coarse cell widened by factor on both sides,
+     * which also covers the drift of up to factor - 1 seams removed since the level was built
+     */
+    const size_t band = 3 * factor;
+    std::vector<size_t> bandStart(lines);
+    for (size_t line = 0; line < lines; ++line) {
+        const size_t center = coarse[std::min(line / factor, coarse.size() - 1)] * factor;
+        bandStart[line] = std::min(center > factor ? center - factor : 0, length > band ? length - band : 0);
+    }
+    const size_t bandLength = std::min(band, length);
 
-        for (size_t x = 1; x < rightest; x++)
-            setPixelAncestor(energy[x][row], energy[x + 1][row - 1], x + 1,
-                    energy[x][row - 1], x, energy[x - 1][row - 1], x - 1);
+    return SeamDP::FindBandedSeam<vertical ? 1 : -1>(bandStart, bandLength, length,
+            [this] (size_t line, size_t i) { return vertical ? GetPixelEnergy(i, line) : GetPixelEnergy(line, i); });
+}
 
-        if (row >= 1)
-            setPixelAncestor(energy[rightest][row], energy[rightest][row - 1], rightest,
-                         energy[rightest][row - 1], rightest,
-                         energy[rightest - 1][row - 1],rightest - 1);
-    }
+namespace {
 
-    double minSum = std::numeric_limits<double>::max();
-    size_t minInd = 0;
-    for (size_t x = 0; x <= rightest; ++x) {
-        if (energy[x][lowest].first < minSum) {
-            minSum = energy[x][lowest].first;
-            minInd = x;
+/**
+ * Sum of absolute channel differences
+ */
+double PixelDistance(const Image::Pixel & a, const Image::Pixel & b)
+{
+    return std::abs(Image::GetRedDif(a, b)) + std::abs(Image::GetGreenDif(a, b)) + std::abs(Image::GetBlueDif(a, b));
+}
+
+} // anonymous namespace
+
+template <class Energy, bool vertical>
+void SeamCarver::stripCosts(size_t firstLine, size_t count) const
+{
+    using Cost = CostOf<Energy>;
+    const size_t length = vertical ? GetImageWidth() : GetImageHeight();
+    SeamDP::CostLines<Cost> & buffers = m_workspace.GetLines<Cost>();
+    Cost
+        *cost = buffers.energy.data(),
+        *toFirst = buffers.toFirst.data(),
+        *toThird = buffers.toThird.data();
+    /* columns are contiguous: for vertical seams the strip is filled column by column,
+     * so every pixel, its neighbours and the output of the next line are reused from the cache
+     */
+    const auto fill = [&] (size_t line, size_t i) {
+        Cost & target = cost[(line - firstLine) * length + i];
+        if constexpr (std::is_same_v<Energy, BackwardEnergy>) {
+            (void)toFirst;
+            (void)toThird;
+            target = vertical ? GetPixelEnergy(i, line) : GetPixelEnergy(line, i);
+        } else if constexpr (std::is_same_v<Energy, IntegerEnergy>) {
+            (void)toFirst;
+            (void)toThird;
+            target = vertical ? GetPixelSquaredEnergy(i, line) : GetPixelSquaredEnergy(line, i);
+        } else {
+            static_assert(std::is_same_v<Energy, ForwardEnergy>, "unknown energy policy");
+            const auto pixel = [this] (size_t position, size_t lineId) -> const Image::Pixel & {
+                return vertical ? m_image.GetPixel(position, lineId) : m_image.GetPixel(lineId, position);
+            };
+            const size_t
+                before = i > 0 ? i - 1 : length - 1,
+                after = i + 1 < length ? i + 1 : 0;
+            /// pixels around the removed one are joined whichever the ancestor is
+            target = PixelDistance(pixel(after, line), pixel(before, line)) + pixel(i, line).m_weight;
+            if (line > 0) {
+                /// first candidate is the next pixel for vertical seams and the previous one for horizontal
+                const Image::Pixel & upper = pixel(i, line - 1);
+                toFirst[(line - firstLine) * length + i] = PixelDistance(upper, pixel(vertical ? after : before, line));
+                toThird[(line - firstLine) * length + i] = PixelDistance(upper, pixel(vertical ? before : after, line));
+            }
         }
+    };
+    if constexpr (vertical) {
+        for (size_t i = 0; i < length; ++i)
+            for (size_t line = firstLine; line < firstLine + count; ++line)
+                fill(line, i);
+    } else {
+        for (size_t line = firstLine; line < firstLine + count; ++line)
+            for (size_t i = 0; i < length; ++i)
+                fill(line, i);
     }
-    Seam seam(GetImageHeight());
-    seam[lowest] = minInd;
-    for (size_t y = lowest; y > 0 ; --y) {
-        seam[y - 1] = energy[seam[y]][y].second;
-    }
-    return seam;
 }
 
 void SeamCarver::RemoveHorizontalSeam(const Seam& seam)
 {
+    Compact();
     for (size_t x = 0; x < m_image.m_width; x++) {
         m_image.rewriteColumnFrom(x, seam[x]);
         m_image.m_table[x].pop_back();
@@ -146,35 +368,99 @@ void SeamCarver::RemoveHorizontalSeam(const Seam& seam)
 
 void SeamCarver::RemoveVerticalSeam(const Seam& seam)
 {
+    if (m_compactionPeriod == 1) {
+        // rows are shifted in place, gaps left by a previous period must be closed first
+        Compact();
+        for (size_t y = 0; y < m_image.m_height; y++)
+            m_image.rewriteRowFrom(seam[y], y);
+        m_image.m_table.pop_back();
+        m_image.m_width--;
+        return;
+    }
     for (size_t y = 0; y < m_image.m_height; y++)
-        m_image.rewriteRowFrom(seam[y], y);
-    m_image.m_table.pop_back();
-    m_image.m_width--;
+        m_image.eraseFromRow(seam[y], y);
+    m_image.commitErasedColumn();
+    if (m_compactionPeriod != 0 && m_image.m_pendingColumns >= m_compactionPeriod)
+        Compact();
+}
+
+void SeamCarver::SetCompactionPeriod(size_t seams)
+{
+    m_compactionPeriod = seams;
+    if (m_compactionPeriod == 1)
+        Compact();
+}
+
+void SeamCarver::Compact() const
+{
+    m_image.compactRows();
 }
 
-void SeamCarver::getEnergy(std::vector<std::vector<SmartPixel>> & energy) const {
-    energy.resize(GetImageWidth());
-    for (size_t column = 0; column < GetImageWidth(); column++) {
-        energy[column].reserve(GetImageHeight());
-        for (size_t row = 0; row < GetImageHeight(); row++) {
-            energy[column].emplace_back(GetPixelEnergy(column, row), 0);
+void SeamCarver::InsertVerticalSeams(size_t count)
+{
+    Compact();
+    while (count > 0) {
+        const SeamIndexMap order(m_image, count, SeamIndexMap::Orientation::Vertical);
+        const size_t
+            width = GetImageWidth(),
+            height = GetImageHeight(),
+            inserted = order.GetSeamCount();
+        if (inserted == 0) {
+            // a single column is the only seam there is, so it is repeated
+            m_image = Image(std::vector<std::vector<Image::Pixel>>(count + 1, m_image.m_table.front()));
+            updateSquaredOffset();
+            break;
+        }
+
+        std::vector<std::vector<Image::Pixel>> table(width + inserted,
+                std::vector<Image::Pixel>(height, Image::Pixel(0, 0, 0)));
+        for (size_t y = 0; y < height; ++y) {
+            size_t out = 0;
+            for (size_t x = 0; x < width; ++x) {
+                const Image::Pixel & pixel = m_image.GetPixel(x, y);
+                table[out++][y] = pixel;
+                if (order.GetIndex(x, y) < inserted)
+                    table[out++][y] = Image::GetAverage(pixel, m_image.GetPixel(x + 1 < width ? x + 1 : x - 1, y));
+            }
         }
+        m_image = Image(std::move(table));
+        updateSquaredOffset();
+        count -= inserted;
     }
 }
 
-void SeamCarver::setPixelAncestor( SeamCarver::SmartPixel &Pixel, const SeamCarver::SmartPixel &left, size_t leftInd,
-                                   const SeamCarver::SmartPixel &mid, size_t midInd, const SeamCarver::SmartPixel &right, size_t rightInd ) const {
-    SmartPixel minPixel;
-    if (left.first <= mid.first)
-        minPixel = {left.first, leftInd};
-    else
-        minPixel = {mid.first, midInd};
+void SeamCarver::InsertHorizontalSeams(size_t count)
+{
+    Compact();
+    while (count > 0) {
+        const SeamIndexMap order(m_image, count, SeamIndexMap::Orientation::Horizontal);
+        const size_t
+            width = GetImageWidth(),
+            height = GetImageHeight(),
+            inserted = order.GetSeamCount();
+        if (inserted == 0) {
+            // a single row is the only seam there is, so it is repeated
+            std::vector<std::vector<Image::Pixel>> table(width);
+            for (size_t x = 0; x < width; ++x)
+                table[x].assign(count + 1, m_image.GetPixel(x, 0));
+            m_image = Image(std::move(table));
+            updateSquaredOffset();
+            break;
+        }
 
-    if (minPixel.first <= right.first) {
-        Pixel.first += minPixel.first;
-        Pixel.second = minPixel.second;
-    } else {
-        Pixel.first += right.first;
-        Pixel.second = rightInd;
+        std::vector<std::vector<Image::Pixel>> table(width);
+        for (size_t x = 0; x < width; ++x) {
+            auto & column = table[x];
+            column.reserve(height + inserted);
+            for (size_t y = 0; y < height; ++y) {
+                const Image::Pixel & pixel = m_image.GetPixel(x, y);
+                column.push_back(pixel);
+                if (order.GetIndex(x, y) < inserted)
+                    column.push_back(Image::GetAverage(pixel, m_image.GetPixel(x, y + 1 < height ? y + 1 : y - 1)));
+            }
+        }
+        m_image = Image(std::move(table));
+        updateSquaredOffset();
+        count -= inserted;
     }
 }
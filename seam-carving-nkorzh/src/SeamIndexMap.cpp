@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "SeamCarver.h"
+#include "SeamIndexMap.h"
+
+namespace {
+
+const char mapMagic[4] = {'S', 'I', 'M', '1'};
+
+void PutWord(std::string & buffer, std::uint32_t value)
+{
+    // little endian regardless of the host
+    for (int shift = 0; shift < 32; shift += 8)
+        buffer += static_cast<char>(value >> shift & 0xFF);
+}
+
+std::uint32_t GetWord(const std::string & buffer, size_t pos)
+{
+    std::uint32_t value = 0;
+    for (int shift = 0, i = 0; shift < 32; shift += 8, ++i)
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(buffer[pos + i])) << shift;
+    return value;
+}
+
+} // anonymous namespace
+
+SeamIndexMap::SeamIndexMap(const Image & image, size_t seams, Orientation orientation)
+    : m_orientation(orientation)
+    , m_width(image.m_width)
+    , m_height(image.m_height)
+    , m_seams(std::min(seams, (orientation == Orientation::Vertical ? m_width : m_height) - 1))
+    , m_index(m_width * m_height, Kept)
+{
+    const bool vertical = orientation == Orientation::Vertical;
+    /// original position of every pixel still present in the carved image,
+    /// row by row for vertical seams, column by column for horizontal ones
+    std::vector<std::vector<Index>> origin(vertical ? m_height : m_width,
+            std::vector<Index>(vertical ? m_width : m_height));
+    for (auto & line : origin)
+        for (size_t i = 0; i < line.size(); ++i)
+            line[i] = static_cast<Index>(i);
+
+    SeamCarver carver(image);
+    for (size_t iteration = 0; iteration < m_seams; ++iteration) {
+        const auto seam = vertical ? carver.FindVerticalSeam() : carver.FindHorizontalSeam();
+        for (size_t i = 0; i < origin.size(); ++i) {
+            auto & line = origin[i];
+            const size_t
+                x = vertical ? line[seam[i]] : i,
+                y = vertical ? i : line[seam[i]];
+            m_index[x * m_height + y] = static_cast<Index>(iteration);
+            line.erase(line.begin() + static_cast<std::ptrdiff_t>(seam[i]));
+        }
+        if (vertical)
+            carver.RemoveVerticalSeam(seam);
+        else
+            carver.RemoveHorizontalSeam(seam);
+    }
+}
+
+SeamIndexMap::Orientation SeamIndexMap::GetOrientation() const
+{
+    return m_orientation;
+}
+
+size_t SeamIndexMap::GetWidth() const
+{
+    return m_width;
+}
+
+size_t SeamIndexMap::GetHeight() const
+{
+    return m_height;
+}
+
+size_t SeamIndexMap::GetMinWidth() const
+{
+    return m_orientation == Orientation::Vertical ? m_width - m_seams : m_width;
+}
+
+size_t SeamIndexMap::GetMinHeight() const
+{
+    return m_orientation == Orientation::Horizontal ? m_height - m_seams : m_height;
+}
+
+size_t SeamIndexMap::GetSeamCount() const
+{
+    return m_seams;
+}
+
+SeamIndexMap::Index SeamIndexMap::GetIndex(size_t columnId, size_t rowId) const
+{
+    return m_index[columnId * m_height + rowId];
+}
+
+Image SeamIndexMap::Resize(const Image & image, size_t size) const
+{
+    const bool vertical = m_orientation == Orientation::Vertical;
+    const size_t
+        full = vertical ? m_width : m_height,
+        target = std::max(std::min(size, full), full - m_seams);
+    /// pixels removed at iterations [0, removed) are dropped, every line loses exactly `removed` of them
+    const Index removed = static_cast<Index>(full - target);
+
+    std::vector<std::vector<Image::Pixel>> table(vertical ? target : m_width,
+            std::vector<Image::Pixel>(vertical ? m_height : target, Image::Pixel(0, 0, 0)));
+    if (vertical) {
+        for (size_t y = 0; y < m_height; ++y) {
+            size_t out = 0;
+            for (size_t x = 0; x < m_width; ++x)
+                if (GetIndex(x, y) >= removed)
+                    table[out++][y] = image.GetPixel(x, y);
+        }
+    } else {
+        for (size_t x = 0; x < m_width; ++x) {
+            size_t out = 0;
+            for (size_t y = 0; y < m_height; ++y)
+                if (GetIndex(x, y) >= removed)
+                    table[x][out++] = image.GetPixel(x, y);
+        }
+    }
+    return Image(std::move(table));
+}
+
+bool SeamIndexMap::Save(const std::string & filename) const
+{
+    std::string buffer(mapMagic, sizeof(mapMagic));
+    buffer.reserve(sizeof(mapMagic) + (4 + m_index.size()) * sizeof(Index));
+    PutWord(buffer, static_cast<std::uint32_t>(m_width));
+    PutWord(buffer, static_cast<std::uint32_t>(m_height));
+    PutWord(buffer, static_cast<std::uint32_t>(m_seams));
+    PutWord(buffer, static_cast<std::uint32_t>(m_orientation));
+    for (Index index : m_index)
+        PutWord(buffer, index);
+
+    std::ofstream output(filename, std::ios::binary);
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    output.close();
+    return !output.fail();
+}
+
+bool SeamIndexMap::Load(const std::string & filename)
+{
+    std::ifstream input(filename, std::ios::binary);
+    if (!input.good())
+        return false;
+    std::string buffer((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    const size_t headerSize = sizeof(mapMagic) + 4 * sizeof(Index);
+    if (buffer.size() < headerSize || buffer.compare(0, sizeof(mapMagic), mapMagic, sizeof(mapMagic)) != 0)
+        return false;
+    const size_t
+        width = GetWord(buffer, sizeof(mapMagic)),
+        height = GetWord(buffer, sizeof(mapMagic) + 4),
+        seams = GetWord(buffer, sizeof(mapMagic) + 8),
+        orientation = GetWord(buffer, sizeof(mapMagic) + 12);
+    if (orientation > static_cast<size_t>(Orientation::Horizontal)
+            || seams >= (orientation == static_cast<size_t>(Orientation::Vertical) ? width : height)
+            || buffer.size() != headerSize + width * height * sizeof(Index))
+        return false;
+
+    m_orientation = static_cast<Orientation>(orientation);
+    m_width = width;
+    m_height = height;
+    m_seams = seams;
+    m_index.resize(width * height);
+    for (size_t i = 0; i < m_index.size(); ++i)
+        m_index[i] = GetWord(buffer, headerSize + i * sizeof(Index));
+    return true;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "SeamDP.h"
+#include "SequenceCarver.h"
+
+SequenceCarver::SequenceCarver(size_t seams, int threshold, size_t window)
+    : m_seams(seams), m_threshold(threshold), m_window(window)
+{}
+
+const std::vector<SequenceCarver::Seam> & SequenceCarver::GetSeams() const
+{
+    return m_previous;
+}
+
+size_t SequenceCarver::GetRecomputedPixels() const
+{
+    return m_recomputed;
+}
+
+Image SequenceCarver::CarveFrame(Image frame)
+{
+    const size_t width = frame.m_width, height = frame.m_height;
+    const bool carried = m_carver && width == m_width && height == m_height;
+    if (m_carver) {
+        m_carver->SetImage(std::move(frame));
+    } else {
+        m_carver.emplace(std::move(frame));
+        // gaps are closed once the whole frame is carved
+        m_carver->SetCompactionPeriod(0);
+    }
+    const Image & image = m_carver->GetImage();
+
+    if (!carried) {
+        m_width = width;
+        m_height = height;
+        m_reference = image.m_table;
+        m_energy.resize(width * height);
+        for (size_t x = 0; x < width; ++x)
+            for (size_t y = 0; y < height; ++y)
+                m_energy[y * width + x] = m_carver->GetPixelEnergy(x, y);
+        m_recomputed = width * height;
+        carveExact();
+    } else {
+        /// energy of a pixel depends on it and its four neighbours
+        std::vector<char> dirty(width * height, 0);
+        const auto changed = [this] (const Image::Pixel & a, const Image::Pixel & b) {
+            return std::abs(a.m_red - b.m_red) > m_threshold || std::abs(a.m_green - b.m_green) > m_threshold
+                    || std::abs(a.m_blue - b.m_blue) > m_threshold || a.m_weight != b.m_weight;
+        };
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t y = 0; y < height; ++y) {
+                Image::Pixel & reference = m_reference[x][y];
+                const Image::Pixel & pixel = image.m_table[x][y];
+                if (!changed(reference, pixel))
+                    continue;
+                reference = pixel;
+                const size_t
+                    left = x > 0 ? x - 1 : width - 1,
+                    right = x + 1 < width ? x + 1 : 0,
+                    top = y > 0 ? y - 1 : height - 1,
+                    bottom = y + 1 < height ? y + 1 : 0;
+                dirty[y * width + x] = dirty[y * width + left] = dirty[y * width + right] = 1;
+                dirty[top * width + x] = dirty[bottom * width + x] = 1;
+            }
+        }
+        m_recomputed = 0;
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t y = 0; y < height; ++y) {
+                if (dirty[y * width + x]) {
+                    m_energy[y * width + x] = m_carver->GetPixelEnergy(x, y);
+                    ++m_recomputed;
+                }
+            }
+        }
+        carveNearPrevious();
+    }
+    m_carver->Compact();
+    return m_carver->GetImage();
+}
+
+void SequenceCarver::carveExact()
+{
+    m_previous.clear();
+    const size_t seams = std::min(m_seams, m_width - 1);
+    for (size_t k = 0; k < seams; ++k) {
+        m_previous.push_back(m_carver->FindVerticalSeam());
+        m_carver->RemoveVerticalSeam(m_previous.back());
+    }
+}
+
+void SequenceCarver::carveNearPrevious()
+{
+    m_carved = m_energy;
+    std::vector<size_t> bandStart(m_height);
+    for (Seam & previous : m_previous) {
+        const size_t
+            width = m_carver->GetImageWidth(),
+            bandLength = std::min(2 * m_window + 1, width);
+        for (size_t y = 0; y < m_height; ++y)
+            bandStart[y] = std::min(previous[y] > m_window ? previous[y] - m_window : 0, width - bandLength);
+        previous = SeamDP::FindBandedSeam<1>(bandStart, bandLength, width,
+                [this] (size_t line, size_t i) { return m_carved[line * m_width + i]; });
+        removeSeam(previous);
+    }
+}
+
+void SequenceCarver::removeSeam(const Seam & seam)
+{
+    m_carver->RemoveVerticalSeam(seam);
+    const size_t width = m_carver->GetImageWidth();
+    for (size_t y = 0; y < m_height; ++y) {
+        double * row = &m_carved[y * m_width];
+        std::memmove(row + seam[y], row + seam[y] + 1, (width - seam[y]) * sizeof(double));
+    }
+    /* pixels next to the seam got new left/right neighbours, pixels between the seam
+     * positions of adjacent rows got new top/bottom ones, the first and the last columns
+     * wrap around to each other
+     */
+    for (size_t y = 0; y < m_height; ++y) {
+        const size_t
+            above = seam[y > 0 ? y - 1 : m_height - 1],
+            below = seam[y + 1 < m_height ? y + 1 : 0],
+            low = std::min({above, seam[y], below}),
+            high = std::min(std::max({above, seam[y], below}), width - 1);
+        double * row = &m_carved[y * m_width];
+        for (size_t x = low > 0 ? low - 1 : 0; x <= high; ++x)
+            row[x] = m_carver->GetPixelEnergy(x, y);
+        row[0] = m_carver->GetPixelEnergy(0, y);
+        row[width - 1] = m_carver->GetPixelEnergy(width - 1, y);
+    }
+}
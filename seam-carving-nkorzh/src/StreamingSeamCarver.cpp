@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImageIO.h"
+#include "StreamingSeamCarver.h"
+
+StreamingSeamCarver::~StreamingSeamCarver()
+{
+    Close();
+}
+
+bool StreamingSeamCarver::Open(const std::string & filename)
+{
+    Close();
+    m_file = open(filename.c_str(), O_RDWR);
+    if (m_file < 0)
+        return false;
+    struct stat status;
+    if (fstat(m_file, &status) != 0 || status.st_size <= 0) {
+        Close();
+        return false;
+    }
+    m_fileSize = static_cast<size_t>(status.st_size);
+    void * mapping = mmap(nullptr, m_fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (mapping == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    m_data = static_cast<unsigned char *>(mapping);
+
+    if (!ImageIO::ParsePPMHeader(reinterpret_cast<const char *>(m_data), m_fileSize,
+                m_width, m_height, m_maxValue, m_headerSize)
+            || m_maxValue == 0 || m_maxValue > 255 || m_width == 0 || m_height == 0
+            || m_width > (m_fileSize - m_headerSize) / 3 / m_height
+            || header().size() > m_headerSize) {
+        Close();
+        return false;
+    }
+    m_stride = m_width * 3;
+    return true;
+}
+
+bool StreamingSeamCarver::Close()
+{
+    bool good = true;
+    if (m_data != nullptr) {
+        size_t fileSize = m_fileSize;
+        const std::string header = m_stride != 0 ? this->header() : std::string();
+        if (header.size() > m_headerSize) {
+            good = false;
+        }
+        else if (m_stride != 0) {
+            // Open checked the new header fits in place of the old one and rows only get shorter,
+            // so every move goes towards the beginning of the file
+            const size_t rowSize = m_width * 3;
+            for (size_t y = 0; y < m_height; ++y)
+                std::memmove(m_data + header.size() + y * rowSize, m_data + m_headerSize + y * m_stride, rowSize);
+            std::memcpy(m_data, header.data(), header.size());
+            fileSize = header.size() + m_height * rowSize;
+        }
+        munmap(m_data, m_fileSize);
+        good = ftruncate(m_file, static_cast<off_t>(fileSize)) == 0 && good;
+        m_data = nullptr;
+    }
+    if (m_file >= 0) {
+        close(m_file);
+        m_file = -1;
+    }
+    m_width = m_height = m_stride = m_maxValue = 0;
+    return good;
+}
+
+void StreamingSeamCarver::SetStripHeight(size_t rows)
+{
+    m_stripHeight = std::max<size_t>(rows, 1);
+}
+
+size_t StreamingSeamCarver::GetImageWidth() const
+{
+    return m_width;
+}
+
+size_t StreamingSeamCarver::GetImageHeight() const
+{
+    return m_height;
+}
+
+std::string StreamingSeamCarver::header() const
+{
+    return "P6\n" + std::to_string(m_width) + " " + std::to_string(m_height) + "\n" + std::to_string(m_maxValue) + "\n";
+}
+
+const unsigned char * StreamingSeamCarver::pixel(size_t columnId, size_t rowId) const
+{
+    return m_data + m_headerSize + rowId * m_stride + columnId * 3;
+}
+
+double StreamingSeamCarver::GetPixelEnergy(size_t columnId, size_t rowId) const
+{
+    auto SQR = [] (double value) { return value * value; };
+    const unsigned char
+        *Left = pixel(columnId > 0 ? columnId - 1 : m_width - 1, rowId),
+        *Right = pixel(columnId < m_width - 1 ? columnId + 1 : 0, rowId),
+        *Top = pixel(columnId, rowId > 0 ? rowId - 1 : m_height - 1),
+        *Bottom = pixel(columnId, rowId < m_height - 1 ? rowId + 1 : 0);
+    double deltaX = 0, deltaY = 0;
+    for (size_t channel = 0; channel < 3; ++channel) {
+        deltaX += SQR(static_cast<double>(Right[channel] - Left[channel]));
+        deltaY += SQR(static_cast<double>(Bottom[channel] - Top[channel]));
+    }
+    return sqrt(deltaX + deltaY);
+}
+
+StreamingSeamCarver::Seam StreamingSeamCarver::FindVerticalSeam()
+{
+    const size_t
+        width = m_width,
+        height = m_height,
+        last = width - 1;
+    m_strip.resize(m_stripHeight * width);
+    m_prev.resize(width);
+    m_cost.resize(width);
+    m_offsets.assign(width, 0);
+    m_directions.Reset(height, width);
+
+    for (size_t stripStart = 0; stripStart < height; stripStart += m_stripHeight) {
+        const size_t rows = std::min(m_stripHeight, height - stripStart);
+        for (size_t r = 0; r < rows; ++r)
+            for (size_t x = 0; x < width; ++x)
+                m_strip[r * width + x] = GetPixelEnergy(x, stripStart + r);
+
+        for (size_t r = 0; r < rows; ++r) {
+            const double * energy = &m_strip[r * width];
+            if (stripStart + r == 0) {
+                m_prev.assign(energy, energy + width);
+                continue;
+            }
+            m_cost.assign(energy, energy + width);
+            const size_t firstEdge = std::min<size_t>(1, last);
+            SeamDP::RelaxEdge(m_cost[0], m_offsets[0], 0, m_prev[firstEdge], firstEdge, m_prev[0], 0);
+            SeamDP::RelaxLine<1, false>(m_prev.data(), m_cost.data(), nullptr, nullptr, m_offsets.data(), width);
+            if (last >= 1)
+                SeamDP::RelaxEdge(m_cost[last], m_offsets[last], last, m_prev[last], last, m_prev[last - 1], last - 1);
+            m_directions.Store(stripStart + r, m_offsets.data(), width);
+            m_prev.swap(m_cost);
+        }
+    }
+
+    double minSum = std::numeric_limits<double>::max();
+    size_t minInd = 0;
+    for (size_t x = 0; x <= last; ++x) {
+        if (m_prev[x] < minSum) {
+            minSum = m_prev[x];
+            minInd = x;
+        }
+    }
+    Seam seam(height);
+    seam[height - 1] = minInd;
+    for (size_t y = height - 1; y > 0; --y)
+        seam[y - 1] = static_cast<size_t>(static_cast<int>(seam[y]) + m_directions.Get(y, seam[y]));
+    return seam;
+}
+
+void StreamingSeamCarver::RemoveVerticalSeam(const Seam & seam)
+{
+    for (size_t y = 0; y < m_height; ++y) {
+        unsigned char * removed = m_data + m_headerSize + y * m_stride + seam[y] * 3;
+        std::memmove(removed, removed + 3, (m_width - 1 - seam[y]) * 3);
+    }
+    --m_width;
+}
+
+size_t StreamingSeamCarver::GetResidentSize() const
+{
+    return (m_strip.capacity() + m_prev.capacity() + m_cost.capacity()) * sizeof(double)
+            + m_offsets.capacity() * sizeof(SeamDP::Offset) + m_directions.GetSize();
+}
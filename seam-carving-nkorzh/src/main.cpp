@@ -1,76 +1,105 @@
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
-#include <fstream>
+#include <string>
 
+#include "Batch.h"
 #include "Image.h"
+#include "ImageIO.h"
 #include "SeamCarver.h"
+#include "StreamingSeamCarver.h"
 
-static std::vector<std::vector<Image::Pixel>> ReadImageFromCSV(std::ifstream& input)
+static int CarveStreaming(const char * source, const char * target, size_t pixelsToDelete)
 {
-    size_t width, height;
-    input >> width >> height;
-    std::vector<std::vector<Image::Pixel>> table;
-    for (size_t columnId = 0; columnId < width; ++columnId)
+    std::error_code error;
+    std::filesystem::copy_file(source, target, std::filesystem::copy_options::overwrite_existing, error);
+    StreamingSeamCarver carver;
+    if (error || !carver.Open(target))
     {
-        std::vector<Image::Pixel> column;
-        for (size_t rowId = 0; rowId < height; ++rowId)
-        {
-            size_t red, green, blue;
-            input >> red >> green >> blue;
-            column.emplace_back(red, green, blue);
-        }
-        table.emplace_back(std::move(column));
+        std::cout << "Can't map " << target << ". Source must be a binary 8 bit PPM file." << std::endl;
+        return 0;
     }
-    return table;
+    std::cout << "Image: " << carver.GetImageWidth() << "x" << carver.GetImageHeight() << std::endl;
+    for (size_t i = 0; i < pixelsToDelete; ++i)
+        carver.RemoveVerticalSeam(carver.FindVerticalSeam());
+    std::cout << "DP buffers: " << carver.GetResidentSize() << " bytes" << std::endl;
+    if (carver.Close())
+        std::cout << "Updated image is written to " << target << "." << std::endl;
+    else
+        std::cout << "Can't write updated image to " << target << "." << std::endl;
+    return 0;
 }
 
-static void WriteImageToCSV(const SeamCarver& carver, std::ofstream& output)
+static int CarveBatch(const char * manifest, size_t threads)
 {
-    const size_t width = carver.GetImageWidth();
-    const size_t height = carver.GetImageHeight();
-    output << width << " " << height << "\n";
-    const Image& image = carver.GetImage();
-    for (size_t columnId = 0; columnId < width; ++columnId)
+    std::vector<Batch::Job> jobs;
+    if (!Batch::ReadManifest(manifest, jobs))
     {
-        for (size_t rowId = 0; rowId < height; ++rowId)
-        {
-            const Image::Pixel& pixel = image.GetPixel(columnId, rowId);
-            output << pixel.m_red << " " << pixel.m_green << " " << pixel.m_blue << std::endl;
-        }
+        std::cout << "Can't read manifest " << manifest << ". Every line must be \"input output width height\"." << std::endl;
+        return 0;
     }
+    const Batch::Report report = Batch::Run(jobs, threads);
+    for (size_t i = 0; i < jobs.size(); ++i)
+        if (!report.results[i].done)
+            std::cout << "Can't process " << jobs[i].input << " -> " << jobs[i].output << ".\n";
+    std::cout << "Jobs: " << jobs.size() - report.failed << " done, " << report.failed << " failed in "
+            << report.seconds << " s\n";
+    std::cout << "Throughput: " << report.jobsPerSecond << " jobs/s, " << report.megapixelsPerSecond << " MP/s\n";
+    std::cout << "Latency, ms: p50 " << report.p50 * 1e3 << ", p90 " << report.p90 * 1e3
+            << ", p99 " << report.p99 * 1e3 << ", max " << report.max * 1e3 << std::endl;
+    return 0;
 }
 
 int main(int argc, char* argv[])
 {
+    const size_t pixelsToDelete = 150;
     // Check command line arguments
     const size_t expectedAmountOfArgs = 3;
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--batch")
+    {
+        return CarveBatch(argv[2], argc == 4 ? std::strtoul(argv[3], nullptr, 10) : 0);
+    }
+    if (argc == expectedAmountOfArgs + 1 && std::string(argv[1]) == "--stream")
+    {
+        return CarveStreaming(argv[2], argv[3], pixelsToDelete);
+    }
     if (argc != expectedAmountOfArgs)
     {
         std::cout << "Wrong amount of arguments. Provide filenames as arguments. See example below:\n";
-        std::cout << "seam-carving data/tower.csv data/tower_updated.csv" << std::endl;
+        std::cout << "seam-carving data/tower.csv data/tower_updated.csv\n";
+        std::cout << "seam-carving --stream data/huge.ppm data/huge_updated.ppm\n";
+        std::cout << "seam-carving --batch data/manifest.txt [threads]" << std::endl;
+        return 0;
+    }
+    // Check file formats
+    const ImageIO::Format inputFormat = ImageIO::GetFormat(argv[1]);
+    const ImageIO::Format outputFormat = ImageIO::GetFormat(argv[2]);
+    if (inputFormat == ImageIO::Format::Unknown || outputFormat == ImageIO::Format::Unknown)
+    {
+        std::cout << "Unknown file format. Supported extensions: .csv, .ppm, .pnm, .pam" << std::endl;
         return 0;
     }
-    // Check csv file
-    std::ifstream inputFile(argv[1]);
-    if (!inputFile.good())
+    // Check source file
+    ImageIO::Table imageSource;
+    if (!ImageIO::Read(argv[1], inputFormat, imageSource))
     {
-        std::cout << "Can't open source file " << argv[1] << ". Verify that the file exists." << std::endl;
+        std::cout << "Can't read source file " << argv[1] << ". Verify that the file exists and is well-formed." << std::endl;
     }
     else
     {
-        auto imageSource = ReadImageFromCSV(inputFile);
         SeamCarver carver(std::move(imageSource));
         std::cout << "Image: " << carver.GetImageWidth() << "x" << carver.GetImageHeight() << std::endl;
-        const size_t pixelsToDelete = 150;
 
         for (size_t i = 0; i < pixelsToDelete; ++i)
         {
             std::vector<size_t> seam = carver.FindVerticalSeam();
             carver.RemoveVerticalSeam(seam);
-            std::cout << "width = " << carver.GetImageWidth() << ", height = " << carver.GetImageHeight() << std::endl;
+            std::cout << "width = " << carver.GetImageWidth() << ", height = " << carver.GetImageHeight() << "\n";
         }
-        std::ofstream outputFile(argv[2]);
-        WriteImageToCSV(carver, outputFile);
-        std::cout << "Updated image is written to " << argv[2] << "." << std::endl;
+        if (ImageIO::Write(argv[2], outputFormat, carver.GetImage()))
+            std::cout << "Updated image is written to " << argv[2] << "." << std::endl;
+        else
+            std::cout << "Can't write updated image to " << argv[2] << "." << std::endl;
     }
     return 0;
 }